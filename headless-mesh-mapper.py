@@ -23,7 +23,10 @@
 import os
 import time
 import json
+import struct
 import csv
+import queue
+import sqlite3
 import logging
 import threading
 import argparse
@@ -34,6 +37,7 @@ import urllib3
 import serial
 import serial.tools.list_ports
 import zmq
+from collections import deque
 from datetime import datetime, timedelta
 from urllib.parse import urlparse
 from typing import Optional, List, Dict, Any
@@ -56,7 +60,42 @@ logger = logging.getLogger("mesh-mapper-headless")
 
 # Initialize global variables
 tracked_pairs = {}
-detection_history = []
+
+# Detection history: the newest HISTORY_RING_SIZE detections in memory and
+# every detection in an append-only SQLite log indexed by MAC and by time.
+# CSV, KML and the log are written by the main loop every FLUSH_INTERVAL
+# seconds instead of on each detection.
+HISTORY_RING_SIZE = 10000
+FLUSH_INTERVAL = 2.0
+CSV_FIELDS = [
+    'timestamp', 'alias', 'mac', 'rssi', 'drone_lat', 'drone_long',
+    'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id', 'faa_data'
+]
+# Detections a node kept in flash while no host was connected, read back with
+# "DRAIN" on connect. They are history, so they go to the backlog CSV and
+# the history log rather than into the tracked drones.
+BACKLOG_FIELDS = [
+    'port', 'rx_us', 'mac', 'rssi', 'drone_lat', 'drone_long',
+    'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id'
+]
+KML_CLOSING = "</Document>\n</kml>"
+
+# FAA lookups run on their own thread so detection handling never waits on
+# uasdoc.faa.gov. A remote ID is queued once however many MACs ask for it.
+# Answers are cached in faa_cache.csv with the time they arrived: a
+# registration is looked up again after FAA_CACHE_TTL seconds, an answer with
+# no registrations after FAA_NEGATIVE_TTL. Failed queries are not cached and
+# wait FAA_FAILURE_BACKOFF seconds before the next try.
+FAA_CACHE_FIELDS = ["mac", "remote_id", "faa_response", "cached_at"]
+FAA_CACHE_TTL = 7 * 24 * 3600
+FAA_NEGATIVE_TTL = 6 * 3600
+FAA_LOOKUP_QUEUE_SIZE = 64
+FAA_MIN_INTERVAL = 2.0
+FAA_FAILURE_BACKOFF = 300
+
+
+def faa_has_items(faa_data):
+    return bool(faa_data and faa_data.get("data", {}).get("items"))
 
 # Serial connection tracking
 zmq_contexts = {}
@@ -64,6 +103,8 @@ zmq_sockets = {}
 zmq_threads = {}
 SELECTED_PORTS = {}
 BAUD_RATE = 115200
+TIME_SYNC_INTERVAL = 10  # Seconds between "TIME <unix_us>" sent to each node; also keeps its flash backlog off
+UNIX_RX_US = 10**15      # rx_us at or above this is Unix time; below, time since the node booted
 staleThreshold = 60  # Default stale threshold in seconds
 serial_connected_status = {}
 last_mac_by_port = {}
@@ -73,6 +114,207 @@ serial_objs_lock = threading.Lock()
 # Webhook URL
 WEBHOOK_URL = None
 
+# ----------------------
+# Binary Detection Frames
+# ----------------------
+# Firmware switched to binary output ("OUTPUT BINARY") sends each detection as
+#   0xA5 0x5A | type | len | payload | crc16 (CRC-16/CCITT-FALSE, little endian)
+# between its ordinary text lines. See detection_frame.h for the payload layout.
+FRAME_SYNC = b'\xa5\x5a'
+FRAME_TYPE_DETECTION = 0x01
+FRAME_TYPE_STORED = 0x02  # A detection from the node's flash backlog, only sent on "DRAIN"
+MAX_TEXT_BUFFER = 4096
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+def decode_detection_payload(payload):
+    if len(payload) < 7:
+        return None
+    detection = {
+        "mac": ":".join(f"{b:02x}" for b in payload[:6]),
+        "rssi": struct.unpack_from('<b', payload, 6)[0],
+    }
+    pos = 7
+    while pos + 2 <= len(payload):
+        tag, size = payload[pos], payload[pos + 1]
+        body = payload[pos + 2:pos + 2 + size]
+        pos += 2 + size
+        if len(body) != size:
+            break
+        if tag == 0 and size >= 1:    # Basic ID
+            detection["ua_type"] = body[0]
+            detection["basic_id"] = body[1:].decode('ascii', errors='ignore')
+        elif tag == 1 and size >= 10:  # Location
+            lat, lon, alt = struct.unpack_from('<iih', body)
+            detection["drone_lat"] = lat / 1e7
+            detection["drone_long"] = lon / 1e7
+            detection["drone_altitude"] = alt
+        elif tag == 2 and size >= 4:   # Auth
+            auth_type, last_page, pages = struct.unpack_from('<BBH', body)
+            detection["auth_type"] = auth_type
+            detection["auth_last_page"] = last_page
+            detection["auth_pages"] = pages
+        elif tag == 3:                 # Self ID
+            detection["description"] = body.decode('ascii', errors='ignore')
+        elif tag == 4 and size >= 8:   # System
+            lat, lon = struct.unpack_from('<ii', body)
+            detection["pilot_lat"] = lat / 1e7
+            detection["pilot_long"] = lon / 1e7
+        elif tag == 5:                 # Operator ID
+            detection["operator_id"] = body.decode('ascii', errors='ignore')
+        elif tag == 8 and size >= 8:   # RX time
+            detection["rx_us"] = struct.unpack_from('<Q', body)[0]
+    return detection
+
+class SerialStreamDecoder:
+    """Splits raw serial bytes into text lines (str) and binary detections (dict)."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        messages = []
+        while self.buffer:
+            sync = self.buffer.find(FRAME_SYNC)
+            newline = self.buffer.find(b'\n')
+            if newline != -1 and (sync == -1 or newline < sync):
+                messages.append(self.buffer[:newline].decode('utf-8', errors='ignore'))
+                del self.buffer[:newline + 1]
+                continue
+            if sync == -1:
+                # Wait for the rest of the line, keeping a byte that may start a frame
+                if len(self.buffer) > MAX_TEXT_BUFFER:
+                    del self.buffer[:-1]
+                break
+            if sync > 0:
+                messages.append(self.buffer[:sync].decode('utf-8', errors='ignore'))
+                del self.buffer[:sync]
+            if len(self.buffer) < 4:
+                break
+            total = 4 + self.buffer[3] + 2
+            if len(self.buffer) < total:
+                break
+            frame = bytes(self.buffer[:total])
+            if frame[2] not in (FRAME_TYPE_DETECTION, FRAME_TYPE_STORED) or \
+                    crc16_ccitt(frame[2:-2]) != int.from_bytes(frame[-2:], 'little'):
+                del self.buffer[:1]  # Not a frame after all; resync on the next sync bytes
+                continue
+            del self.buffer[:total]
+            detection = decode_detection_payload(frame[4:-2])
+            if detection:
+                if frame[2] == FRAME_TYPE_STORED:
+                    detection["backlog"] = True
+                messages.append(detection)
+        return messages
+
+
+class DetectionHistory:
+    """Bounded ring of recent detections plus an append-only log on disk."""
+
+    def __init__(self, db_path, ring_size=HISTORY_RING_SIZE):
+        self.ring = deque(maxlen=ring_size)
+        self.total = 0
+        self.pending = []
+        self.lock = threading.Lock()     # ring and pending, taken by every reader thread
+        self.db_lock = threading.Lock()  # the connection, so appends never wait on a commit
+        self.db = sqlite3.connect(str(db_path), check_same_thread=False)
+        self.db.execute("PRAGMA journal_mode=WAL")
+        self.db.execute(
+            "CREATE TABLE IF NOT EXISTS detections ("
+            "ts REAL NOT NULL, mac TEXT NOT NULL, basic_id TEXT, rssi INTEGER, "
+            "drone_lat REAL, drone_long REAL, pilot_lat REAL, pilot_long REAL, "
+            "record TEXT NOT NULL)")
+        self.db.execute("CREATE INDEX IF NOT EXISTS detections_mac_ts ON detections (mac, ts)")
+        self.db.execute("CREATE INDEX IF NOT EXISTS detections_ts ON detections (ts)")
+        self.db.commit()
+
+    def append(self, detection):
+        record = detection.copy()
+        row = (
+            record.get('last_update') or time.time(), record.get('mac', ''), record.get('basic_id'),
+            record.get('rssi'), record.get('drone_lat'), record.get('drone_long'),
+            record.get('pilot_lat'), record.get('pilot_long'), json.dumps(record, default=str)
+        )
+        with self.lock:
+            self.ring.append(record)
+            self.total += 1
+            self.pending.append(row)
+
+    def flush(self):
+        """Writes the queued detections in one transaction."""
+        with self.lock:
+            rows, self.pending = self.pending, []
+        if rows:
+            with self.db_lock:
+                self.db.executemany("INSERT INTO detections VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)", rows)
+                self.db.commit()
+        return len(rows)
+
+    def query(self, mac=None, since=None, until=None, limit=1000):
+        """Logged detections, newest first, by MAC and/or time range (Unix seconds)."""
+        self.flush()
+        clauses, params = [], []
+        if mac:
+            clauses.append("mac = ?")
+            params.append(mac)
+        if since is not None:
+            clauses.append("ts >= ?")
+            params.append(since)
+        if until is not None:
+            clauses.append("ts < ?")
+            params.append(until)
+        where = f" WHERE {' AND '.join(clauses)}" if clauses else ""
+        with self.db_lock:
+            cursor = self.db.execute(f"SELECT record FROM detections{where} ORDER BY ts DESC LIMIT ?",
+                                     params + [limit])
+            return [json.loads(row[0]) for row in cursor.fetchall()]
+
+    def recent(self):
+        with self.lock:
+            return list(self.ring)
+
+    def close(self):
+        self.flush()
+        with self.db_lock:
+            self.db.close()
+
+
+class BufferedCsvWriter:
+    """Keeps a CSV open for appending and writes queued rows in one go."""
+
+    def __init__(self, path, fieldnames, truncate=False):
+        write_header = truncate or not os.path.exists(path)
+        self.file = open(path, 'w' if truncate else 'a', newline='')
+        self.writer = csv.DictWriter(self.file, fieldnames=fieldnames)
+        if write_header:
+            self.writer.writeheader()
+            self.file.flush()
+        self.rows = []
+        self.lock = threading.Lock()
+
+    def add(self, row):
+        with self.lock:
+            self.rows.append(row)
+
+    def flush(self):
+        with self.lock:
+            rows, self.rows = self.rows, []
+        if rows:
+            self.writer.writerows(rows)
+            self.file.flush()
+
+    def close(self):
+        self.flush()
+        self.file.close()
+
+
 class MeshMapper:
     def __init__(self, args):
         self.args = args
@@ -94,11 +336,23 @@ class MeshMapper:
         
         # Load aliases and FAA cache
         self.aliases = self.load_aliases()
+        self.faa_by_mac = {}
+        self.faa_by_remote_id = {}
+        self.faa_cached_at = {}
         self.faa_cache = self.load_faa_cache()
+        self.faa_queue = queue.Queue(maxsize=FAA_LOOKUP_QUEUE_SIZE)
+        self.faa_lock = threading.Lock()
+        self.faa_pending = {}
+        self.faa_failed_until = {}
+        threading.Thread(target=self.faa_lookup_worker, daemon=True).start()
         
         # Initialize detection tracking
         self.write_csv_headers()
         self.initialize_cumulative_kml()
+        self.history = DetectionHistory(self.history_db_filename)
+        self.output_lock = threading.Lock()
+        self.kml_dirty = False
+        self.kml_placemarks = []
         
     def setup_file_paths(self):
         """Setup file paths for log and data files"""
@@ -116,6 +370,8 @@ class MeshMapper:
         self.cumulative_csv_filename = output_dir / "cumulative_detections.csv"
         self.aliases_file = output_dir / "aliases.json"
         self.faa_cache_file = output_dir / "faa_cache.csv"
+        self.history_db_filename = output_dir / "detection_history.db"
+        self.backlog_csv_filename = output_dir / f"backlog_{self.startup_timestamp}.csv"
         
         logger.info(f"Using CSV file: {self.csv_filename}")
         logger.info(f"Using KML file: {self.kml_filename}")
@@ -142,35 +398,87 @@ class MeshMapper:
             logger.error(f"Error saving aliases: {e}")
             
     def load_faa_cache(self):
-        """Load FAA cache from file"""
+        """Load FAA cache from file, compacting it to one row per entry when needed"""
         faa_cache = {}
         if os.path.exists(self.faa_cache_file):
+            rows = 0
             try:
+                # Rows from before the cached_at column count from the file's mtime
+                mtime = os.path.getmtime(self.faa_cache_file)
                 with open(self.faa_cache_file, newline='') as csvfile:
                     reader = csv.DictReader(csvfile)
+                    current = "cached_at" in (reader.fieldnames or [])
                     for row in reader:
+                        rows += 1
                         key = (row['mac'], row['remote_id'])
                         faa_cache[key] = json.loads(row['faa_response'])
+                        self.index_faa(row['mac'], row['remote_id'], faa_cache[key], float(row.get('cached_at') or mtime))
                 logger.info(f"Loaded {len(faa_cache)} FAA cache entries from {self.faa_cache_file}")
             except Exception as e:
                 logger.error(f"Error loading FAA cache: {e}")
+                return faa_cache
+            if not current or rows > 2 * len(faa_cache):
+                self.rewrite_faa_cache(faa_cache, mtime)
         return faa_cache
+        
+    def rewrite_faa_cache(self, faa_cache, mtime):
+        """Rewrite faa_cache.csv with the current header and the latest row per entry"""
+        try:
+            tmp = str(self.faa_cache_file) + ".tmp"
+            with open(tmp, "w", newline='') as csvfile:
+                writer = csv.DictWriter(csvfile, fieldnames=FAA_CACHE_FIELDS)
+                writer.writeheader()
+                for (mac, remote_id), faa_data in faa_cache.items():
+                    writer.writerow({
+                        "mac": mac,
+                        "remote_id": remote_id,
+                        "faa_response": json.dumps(faa_data),
+                        "cached_at": self.faa_cached_at.get(remote_id, mtime)
+                    })
+            os.replace(tmp, self.faa_cache_file)
+        except OSError as e:
+            logger.error(f"Error compacting FAA cache: {e}")
+    
+    def index_faa(self, mac, remote_id, faa_data, cached_at):
+        """Latest FAA data per MAC and per remote ID, for lookups without a scan"""
+        # An answer with no registrations does not hide one already known for the MAC
+        if faa_has_items(faa_data) or mac not in self.faa_by_mac:
+            self.faa_by_mac[mac] = faa_data
+        if remote_id:
+            self.faa_by_remote_id[remote_id] = faa_data
+            self.faa_cached_at[remote_id] = cached_at
+            
+    def lookup_faa(self, mac, remote_id):
+        """Cached FAA data: exact (mac, remote_id), then the remote ID on any MAC, then the MAC"""
+        if remote_id:
+            faa_data = self.faa_cache.get((mac, remote_id)) or self.faa_by_remote_id.get(remote_id)
+            if faa_data:
+                return faa_data
+        return self.faa_by_mac.get(mac)
     
+    def faa_cache_fresh(self, remote_id):
+        """True while the cached answer for remote_id is within its TTL"""
+        if remote_id not in self.faa_by_remote_id:
+            return False
+        ttl = FAA_CACHE_TTL if faa_has_items(self.faa_by_remote_id[remote_id]) else FAA_NEGATIVE_TTL
+        return time.time() - self.faa_cached_at.get(remote_id, 0) < ttl
+        
     def write_to_faa_cache(self, mac, remote_id, faa_data):
-        """Write to FAA cache file"""
-        key = (mac, remote_id)
-        self.faa_cache[key] = faa_data
+        """Cache an FAA answer and append it to the cache file"""
+        now = time.time()
+        self.faa_cache[(mac, remote_id)] = faa_data
+        self.index_faa(mac, remote_id, faa_data, now)
         try:
             file_exists = os.path.isfile(self.faa_cache_file)
             with open(self.faa_cache_file, "a", newline='') as csvfile:
-                fieldnames = ["mac", "remote_id", "faa_response"]
-                writer = csv.DictWriter(csvfile, fieldnames=fieldnames)
+                writer = csv.DictWriter(csvfile, fieldnames=FAA_CACHE_FIELDS)
                 if not file_exists:
                     writer.writeheader()
                 writer.writerow({
                     "mac": mac,
                     "remote_id": remote_id,
-                    "faa_response": json.dumps(faa_data)
+                    "faa_response": json.dumps(faa_data),
+                    "cached_at": now
                 })
             logger.debug(f"Added FAA cache entry for {mac}/{remote_id}")
         except Exception as e:
@@ -178,23 +486,9 @@ class MeshMapper:
             
     def write_csv_headers(self):
         """Initialize CSV files with headers"""
-        # Detection CSV header
-        with open(self.csv_filename, mode='w', newline='') as csvfile:
-            fieldnames = [
-                'timestamp', 'alias', 'mac', 'rssi', 'drone_lat', 'drone_long',
-                'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id', 'faa_data'
-            ]
-            writer = csv.DictWriter(csvfile, fieldnames=fieldnames)
-            writer.writeheader()
-            
-            # Cumulative CSV header - if it doesn't exist
-        if not os.path.exists(self.cumulative_csv_filename):
-            with open(self.cumulative_csv_filename, mode='w', newline='') as csvfile:
-                writer = csv.DictWriter(csvfile, fieldnames=[
-                    'timestamp', 'alias', 'mac', 'rssi', 'drone_lat', 'drone_long',
-                    'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id', 'faa_data'
-                ])
-                writer.writeheader()
+        # Session and cumulative CSVs stay open; rows go out with each flush
+        self.session_csv = BufferedCsvWriter(self.csv_filename, CSV_FIELDS, truncate=True)
+        self.cumulative_csv = BufferedCsvWriter(self.cumulative_csv_filename, CSV_FIELDS)
                 
                 # FAA log CSV header - if it doesn't exist
         if not os.path.exists(self.faa_log_filename):
@@ -221,7 +515,7 @@ class MeshMapper:
             '<Document>',
             f'<name>Detections {self.startup_timestamp}</name>'
         ]
-        for mac, det in tracked_pairs.items():
+        for mac, det in list(tracked_pairs.items()):
             alias = self.aliases.get(mac, '')
             aliasStr = f"{alias} " if alias else ""
             remoteIdStr = ""
@@ -254,46 +548,68 @@ class MeshMapper:
         logger.info(f"Updated KML file: {self.kml_filename}")
         
     def append_to_cumulative_kml(self, mac, detection):
-        """Append detection to cumulative KML file"""
+        """Queue the drone and pilot positions for the cumulative KML file"""
         alias = self.aliases.get(mac, '')
         aliasStr = f"{alias} " if alias else ""
-        
-        # Build placemark for drone position
+        placemarks = []
         if detection.get("drone_lat", 0) != 0 and detection.get("drone_long", 0) != 0:
-            placemark = [
+            placemarks += [
                 f"<Placemark><name>Drone {aliasStr}{mac} {datetime.now().isoformat()}</name>",
                 f"<Point><coordinates>{detection['drone_long']},{detection['drone_lat']},0</coordinates></Point>",
                 "</Placemark>"
             ]
-            # Insert before closing tags
-            with open(self.cumulative_kml_filename, "r+") as f:
-                content = f.read()
-                # Strip closing tags
-                content = content.replace("</Document>\n</kml>", "")
-                f.seek(0)
-                f.write(content)
-                f.write("\n" + "\n".join(placemark) + "\n</Document>\n</kml>")
-                
-                # Also add pilot position
         if detection.get("pilot_lat", 0) != 0 and detection.get("pilot_long", 0) != 0:
-            placemark = [
+            placemarks += [
                 f"<Placemark><name>Pilot {aliasStr}{mac} {datetime.now().isoformat()}</name>",
                 f"<Point><coordinates>{detection['pilot_long']},{detection['pilot_lat']},0</coordinates></Point>",
                 "</Placemark>"
             ]
-            with open(self.cumulative_kml_filename, "r+") as f:
-                content = f.read()
-                content = content.replace("</Document>\n</kml>", "")
-                f.seek(0)
-                f.write(content)
-                f.write("\n" + "\n".join(placemark) + "\n</Document>\n</kml>")
+        if placemarks:
+            with self.output_lock:
+                self.kml_placemarks.extend(placemarks)
                 
+    def write_cumulative_kml(self, placemarks):
+        """Append placemarks before the closing tags, without reading the whole file"""
+        closing = KML_CLOSING.encode()
+        with open(self.cumulative_kml_filename, "r+b") as f:
+            f.seek(0, os.SEEK_END)
+            end = f.tell()
+            f.seek(max(0, end - len(closing)))
+            if f.read() == closing:
+                f.seek(end - len(closing))
+            else:
+                f.seek(end)  # Not ours at the end; leave it and append
+            f.write(("\n" + "\n".join(placemarks) + "\n" + KML_CLOSING).encode())
+            f.truncate()
+            
+    def flush_outputs(self):
+        """Write what built up since the last flush: history log, CSVs and KMLs"""
+        self.history.flush()
+        self.session_csv.flush()
+        self.cumulative_csv.flush()
+        with self.output_lock:
+            placemarks, self.kml_placemarks = self.kml_placemarks, []
+            kml_dirty, self.kml_dirty = self.kml_dirty, False
+        if placemarks:
+            self.write_cumulative_kml(placemarks)
+        if kml_dirty:
+            self.generate_kml()
+            
     def update_detection(self, detection):
         """Update detection and track it"""
         mac = detection.get("mac")
         if not mac:
             return
         
+        # Firmware sends only the message groups that changed; merge onto the last known state
+        merged = dict(tracked_pairs.get(mac, {}))
+        for key, value in detection.items():
+            # Older firmware reports coordinates it has not decoded as zero
+            if key in ('drone_lat', 'drone_long', 'pilot_lat', 'pilot_long') and value == 0:
+                continue
+            merged[key] = value
+        detection = merged
+        
         # Retrieve new drone coordinates from the detection
         new_drone_lat = detection.get("drone_lat", 0)
         new_drone_long = detection.get("drone_long", 0)
@@ -303,7 +619,7 @@ class MeshMapper:
             logger.info(f"No-GPS detection for {mac}; forwarding for webhook.")
             # Forward this no-GPS detection to the webhook
             tracked_pairs[mac] = detection
-            detection_history.append(detection.copy())
+            self.history.append(detection)
             
             # Server-side webhook firing for no-GPS detection
             if self.webhook_url:
@@ -328,31 +644,22 @@ class MeshMapper:
             
         remote_id = detection.get("basic_id")
         
-        # Try exact cache lookup by (mac, remote_id), then fallback to any cached data for this mac
+        # Cached FAA data by (mac, remote_id), remote ID or MAC; all dictionary lookups
         if mac:
-            # Exact match if basic_id provided
-            if remote_id:
-                key = (mac, remote_id)
-                if key in self.faa_cache:
-                    detection["faa_data"] = self.faa_cache[key]
-                    
-                    # Fallback: any cached FAA data for this mac
-            if "faa_data" not in detection:
-                for (c_mac, _), faa_data in self.faa_cache.items():
-                    if c_mac == mac:
-                        detection["faa_data"] = faa_data
-                        break
-                    
-                    # Fallback: last known FAA data in tracked_pairs
+            faa_data = self.lookup_faa(mac, remote_id)
+            if faa_data:
+                detection["faa_data"] = faa_data
+                
+                # Fallback: last known FAA data in tracked_pairs
             if "faa_data" not in detection and mac in tracked_pairs and "faa_data" in tracked_pairs[mac]:
                 detection["faa_data"] = tracked_pairs[mac]["faa_data"]
                 
-                # Always cache FAA data by MAC and current basic_id for fallback
-            if "faa_data" in detection:
-                self.write_to_faa_cache(mac, detection.get("basic_id", ""), detection["faa_data"])
+                # Queue a lookup for a remote ID not cached or due again; the answer lands later
+            if remote_id and self.args.faa_lookup and self.faa_lookup_due(remote_id):
+                self.request_faa_lookup(mac, remote_id)
                 
         tracked_pairs[mac] = detection
-        detection_history.append(detection.copy())
+        self.history.append(detection)
         
         # Send notification about new detection if configured
         if self.args.notifications:
@@ -368,48 +675,24 @@ class MeshMapper:
                 
         logger.info(f"Updated detection: MAC={mac}, drone_lat={new_drone_lat}, drone_long={new_drone_long}")
         
-        # Write to session CSV
-        with open(self.csv_filename, mode='a', newline='') as csvfile:
-            writer = csv.DictWriter(csvfile, fieldnames=[
-                'timestamp', 'alias', 'mac', 'rssi', 'drone_lat', 'drone_long',
-                'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id', 'faa_data'
-            ])
-            writer.writerow({
-                'timestamp': datetime.now().isoformat(),
-                'alias': self.aliases.get(mac, ''),
-                'mac': mac,
-                'rssi': detection.get('rssi', ''),
-                'drone_lat': detection.get('drone_lat', ''),
-                'drone_long': detection.get('drone_long', ''),
-                'drone_altitude': detection.get('drone_altitude', ''),
-                'pilot_lat': detection.get('pilot_lat', ''),
-                'pilot_long': detection.get('pilot_long', ''),
-                'basic_id': detection.get('basic_id', ''),
-                'faa_data': json.dumps(detection.get('faa_data', {}))
-            })
-            
-            # Append to cumulative CSV
-        with open(self.cumulative_csv_filename, mode='a', newline='') as csvfile:
-            writer = csv.DictWriter(csvfile, fieldnames=[
-                'timestamp', 'alias', 'mac', 'rssi', 'drone_lat', 'drone_long',
-                'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id', 'faa_data'
-            ])
-            writer.writerow({
-                'timestamp': datetime.now().isoformat(),
-                'alias': self.aliases.get(mac, ''),
-                'mac': mac,
-                'rssi': detection.get('rssi', ''),
-                'drone_lat': detection.get('drone_lat', ''),
-                'drone_long': detection.get('drone_long', ''),
-                'drone_altitude': detection.get('drone_altitude', ''),
-                'pilot_lat': detection.get('pilot_lat', ''),
-                'pilot_long': detection.get('pilot_long', ''),
-                'basic_id': detection.get('basic_id', ''),
-                'faa_data': json.dumps(detection.get('faa_data', {}))
-            })
-            
-            # Update KMLs
-        self.generate_kml()
+        # Queue the CSV rows and KML updates for the next flush
+        row = {
+            'timestamp': datetime.now().isoformat(),
+            'alias': self.aliases.get(mac, ''),
+            'mac': mac,
+            'rssi': detection.get('rssi', ''),
+            'drone_lat': detection.get('drone_lat', ''),
+            'drone_long': detection.get('drone_long', ''),
+            'drone_altitude': detection.get('drone_altitude', ''),
+            'pilot_lat': detection.get('pilot_lat', ''),
+            'pilot_long': detection.get('pilot_long', ''),
+            'basic_id': detection.get('basic_id', ''),
+            'faa_data': json.dumps(detection.get('faa_data', {}))
+        }
+        self.session_csv.add(row)
+        self.cumulative_csv.add(row)
+        with self.output_lock:
+            self.kml_dirty = True
         self.append_to_cumulative_kml(mac, detection)
         
     def notify_detection(self, detection):
@@ -436,49 +719,86 @@ class MeshMapper:
             except Exception as e:
                 logger.error(f"Error sending Windows notification: {e}")
             
-    def query_faa_api(self, mac, remote_id):
-        """Query the FAA API for a remote ID"""
-        session = self.create_retry_session()
-        self.refresh_cookie(session)
-        faa_result = self.query_remote_id(session, remote_id)
-        
-        # Fallback: if FAA API query failed or returned no records, try cached FAA data by MAC
-        if not faa_result or not faa_result.get("data", {}).get("items"):
-            for (c_mac, _), cached_data in self.faa_cache.items():
-                if c_mac == mac:
-                    faa_result = cached_data
-                    break
-                
-        if faa_result is None:
-            logger.error(f"FAA query failed for {mac}/{remote_id}")
-            return None
+    def faa_lookup_due(self, remote_id):
+        """True if remote_id has no fresh cache entry and is neither queued nor backing off"""
+        with self.faa_lock:
+            if remote_id in self.faa_pending or time.time() < self.faa_failed_until.get(remote_id, 0):
+                return False
+        return not self.faa_cache_fresh(remote_id)
         
-        # Update tracked_pairs with the new FAA data
-        if mac in tracked_pairs:
-            tracked_pairs[mac]["faa_data"] = faa_result
-        else:
-            tracked_pairs[mac] = {"basic_id": remote_id, "faa_data": faa_result}
+    def request_faa_lookup(self, mac, remote_id):
+        """Queue an FAA lookup of remote_id for mac; False if the queue is full"""
+        with self.faa_lock:
+            if remote_id in self.faa_pending:
+                self.faa_pending[remote_id].add(mac)
+                return True
+            try:
+                self.faa_queue.put_nowait(remote_id)
+            except queue.Full:
+                logger.debug(f"FAA lookup queue full, dropped {remote_id}")
+                return False
+            self.faa_pending[remote_id] = {mac}
+            return True
             
-        self.write_to_faa_cache(mac, remote_id, faa_result)
-        
-        # Log the FAA query
-        timestamp = datetime.now().isoformat()
-        try:
-            with open(self.faa_log_filename, "a", newline='') as csvfile:
-                fieldnames = ["timestamp", "mac", "remote_id", "faa_response"]
-                writer = csv.DictWriter(csvfile, fieldnames=fieldnames)
-                writer.writerow({
-                    "timestamp": timestamp,
-                    "mac": mac,
-                    "remote_id": remote_id,
-                    "faa_response": json.dumps(faa_result)
-                })
-        except Exception as e:
-            logger.error(f"Error writing to FAA log CSV: {e}")
+    def faa_lookup_worker(self):
+        """Query the FAA API for queued remote IDs, one at a time and at most every FAA_MIN_INTERVAL seconds"""
+        session = None
+        last_query = 0
+        while True:
+            remote_id = self.faa_queue.get()
+            wait = FAA_MIN_INTERVAL - (time.time() - last_query)
+            if wait > 0:
+                time.sleep(wait)
+            if session is None:
+                session = self.create_retry_session()
+                self.refresh_cookie(session)
+            last_query = time.time()
+            faa_result = self.query_remote_id(session, remote_id)
+            with self.faa_lock:
+                macs = self.faa_pending.pop(remote_id)
+                if faa_result is None:
+                    self.faa_failed_until[remote_id] = time.time() + FAA_FAILURE_BACKOFF
+                else:
+                    self.faa_failed_until.pop(remote_id, None)
+            if faa_result is None:
+                logger.error(f"FAA query failed for {remote_id}")
+                session = None  # New session and cookie for the next query
+                continue
+            try:
+                self.apply_faa_result(remote_id, macs, faa_result)
+            except Exception as e:
+                logger.error(f"Error applying FAA result for {remote_id}: {e}")
+                
+    def apply_faa_result(self, remote_id, macs, faa_result):
+        """Cache an FAA answer, attach it to the tracked drones and log it"""
+        for mac in macs:
+            self.write_to_faa_cache(mac, remote_id, faa_result)
             
+            # Update tracked_pairs with the new FAA data, keeping a registration over an empty answer
+            if mac in tracked_pairs:
+                if faa_has_items(faa_result) or not faa_has_items(tracked_pairs[mac].get("faa_data")):
+                    tracked_pairs[mac]["faa_data"] = faa_result
+            else:
+                tracked_pairs[mac] = {"basic_id": remote_id, "faa_data": faa_result}
+                
+            # Log the FAA query
+            timestamp = datetime.now().isoformat()
+            try:
+                with open(self.faa_log_filename, "a", newline='') as csvfile:
+                    fieldnames = ["timestamp", "mac", "remote_id", "faa_response"]
+                    writer = csv.DictWriter(csvfile, fieldnames=fieldnames)
+                    writer.writerow({
+                        "timestamp": timestamp,
+                        "mac": mac,
+                        "remote_id": remote_id,
+                        "faa_response": json.dumps(faa_result)
+                    })
+            except Exception as e:
+                logger.error(f"Error writing to FAA log CSV: {e}")
+                
             # Update KML
-        self.generate_kml()
-        return faa_result
+        with self.output_lock:
+            self.kml_dirty = True
     
     def create_retry_session(self, retries=3, backoff_factor=2, status_forcelist=(502, 503, 504)):
         """Create a retry-enabled session with custom headers for FAA query"""
@@ -535,6 +855,27 @@ class MeshMapper:
             logger.error(f"Error querying FAA API: {e}")
             return None
         
+    def save_backlog(self, port, detections):
+        """Write a drained flash backlog to the backlog CSV and the history log, on disk before it is confirmed"""
+        if not detections:
+            logger.info(f"{port}: no backlog detections")
+            return
+        new_file = not os.path.exists(self.backlog_csv_filename)
+        with open(self.backlog_csv_filename, mode='a', newline='') as csvfile:
+            writer = csv.DictWriter(csvfile, fieldnames=BACKLOG_FIELDS, extrasaction='ignore')
+            if new_file:
+                writer.writeheader()
+            for detection in detections:
+                writer.writerow(dict(detection, port=port))
+        for detection in detections:
+            # Logged at reception time once the node's clock was synced, else now
+            rx_us = detection.get('rx_us', 0)
+            record = dict(detection, port=port)
+            record['last_update'] = rx_us / 1e6 if rx_us >= UNIX_RX_US else time.time()
+            self.history.append(record)
+        self.history.flush()
+        logger.info(f"{port}: {len(detections)} backlog detections saved")
+        
     def start_serial_thread(self, port):
         """Start a serial reader thread for a port"""
         thread = threading.Thread(target=self.serial_reader, args=(port,), daemon=True)
@@ -556,6 +897,10 @@ class MeshMapper:
                     ser = serial.Serial(port, BAUD_RATE, timeout=1)
                     serial_connected_status[port] = True
                     logger.info(f"Opened serial port {port} at {BAUD_RATE} baud.")
+                    decoder = SerialStreamDecoder()
+                    next_time_sync = 0
+                    drain_due = True
+                    backlog = []
                     with serial_objs_lock:
                         serial_objs[port] = ser
                     # Reset retry count on successful connection
@@ -575,39 +920,64 @@ class MeshMapper:
                         continue
                     
             try:
+                if time.time() >= next_time_sync:
+                    ser.write(f"TIME {time.time_ns() // 1000}\n".encode())
+                    next_time_sync = time.time() + TIME_SYNC_INTERVAL
+                    # TIME first, so the node's clock is set before its backlog comes back
+                    if drain_due:
+                        ser.write(b"DRAIN\n")
+                        drain_due = False
                 # Read incoming data
                 if ser.in_waiting:
-                    line = ser.readline().decode('utf-8', errors='ignore').strip()
-                    if not line:
-                        continue
-                    
-                    # Extract JSON
-                    if '{' in line:
-                        json_str = line[line.find('{'):]
-                    else:
-                        json_str = line
-                        
-                        # Parse JSON
-                    try:
-                        detection = json.loads(json_str)
-                        # Track MAC address
-                        if 'mac' in detection:
+                    for message in decoder.feed(ser.read(ser.in_waiting)):
+                        if isinstance(message, dict):
+                            # Binary detection frame
+                            detection = message
                             last_mac_by_port[port] = detection['mac']
-                        elif port in last_mac_by_port:
-                            detection['mac'] = last_mac_by_port[port]
-                    except json.JSONDecodeError:
-                        continue
-                    
-                    # Handle remote_id field
-                    if 'remote_id' in detection and 'basic_id' not in detection:
-                        detection['basic_id'] = detection['remote_id']
+                        else:
+                            line = message.strip()
+                            if not line:
+                                continue
+                            
+                            # Extract JSON
+                            if '{' in line:
+                                json_str = line[line.find('{'):]
+                            else:
+                                json_str = line
+                                
+                            # Parse JSON
+                            try:
+                                detection = json.loads(json_str)
+                                # Track MAC address
+                                if 'mac' in detection:
+                                    last_mac_by_port[port] = detection['mac']
+                                elif port in last_mac_by_port:
+                                    detection['mac'] = last_mac_by_port[port]
+                            except json.JSONDecodeError:
+                                continue
                         
-                        # Skip heartbeat messages
-                    if 'heartbeat' in detection:
-                        continue
-                    
-                    # Process detection
-                    self.update_detection(detection)
+                        # Handle remote_id field
+                        if 'remote_id' in detection and 'basic_id' not in detection:
+                            detection['basic_id'] = detection['remote_id']
+                            
+                        if 'drain' in detection:
+                            # Saved first, so a confirmed backlog is never lost
+                            end = detection['drain'].get('end') if isinstance(detection['drain'], dict) else None
+                            if end is not None:
+                                self.save_backlog(port, backlog)
+                                backlog = []
+                                ser.write(f"DRAIN OK {end}\n".encode())
+                            continue
+                        if detection.get('backlog'):
+                            backlog.append(detection)
+                            continue
+                            
+                        # Skip heartbeat, stats and command acknowledgement messages
+                        if 'heartbeat' in detection or 'output' in detection or 'baud' in detection or 'stats' in detection or 'tasks' in detection or 'records' in detection or 'time' in detection:
+                            continue
+                        
+                        # Process detection
+                        self.update_detection(detection)
                 else:
                     time.sleep(0.1)
                     
@@ -758,6 +1128,7 @@ class MeshMapper:
             # Status update interval
             status_interval = self.args.status_interval
             last_status_time = time.time()
+            last_flush_time = time.time()
             
             # Main loop
             try:
@@ -768,6 +1139,10 @@ class MeshMapper:
                         self.print_status()
                         last_status_time = current_time
                         
+                    if current_time - last_flush_time >= FLUSH_INTERVAL:
+                        self.flush_outputs()
+                        last_flush_time = current_time
+                        
                     # Clean up stale detections
                     global tracked_pairs
                     # Make a copy of the keys to avoid modification during iteration
@@ -817,7 +1192,8 @@ class MeshMapper:
         
         logger.info("=== Mesh-Mapper Status ===")
         logger.info(f"Active detections: {active_count}")
-        logger.info(f"Total historical detections: {len(detection_history)}")
+        logger.info(f"Total historical detections: {self.history.total} ({len(self.history.ring)} in memory)")
+        logger.info(f"FAA lookups queued: {len(self.faa_pending)}, cached remote IDs: {len(self.faa_by_remote_id)}")
         logger.info(f"Serial ports: {', '.join(serial_status) or 'None'}")
         logger.info(f"ZMQ connections: {', '.join(zmq_status) or 'None'}")
         logger.info(f"Stale threshold: {staleThreshold}s")
@@ -841,8 +1217,12 @@ class MeshMapper:
         # Stop ZMQ clients
         self.stop_all_zmq_clients()
         
-        # Final KML generation
+        # Final flush and KML generation
+        self.flush_outputs()
         self.generate_kml()
+        self.session_csv.close()
+        self.cumulative_csv.close()
+        self.history.close()
         
         # Save aliases
         self.save_aliases()
@@ -867,6 +1247,7 @@ def main():
     # Output options
     parser.add_argument('--output-dir', help='Directory to store output files (default: current directory)')
     parser.add_argument('--notifications', action='store_true', help='Enable desktop notifications for new detections')
+    parser.add_argument('--faa-lookup', action='store_true', help='Query the FAA API for each new remote ID')
     
     # General options
     parser.add_argument('--stale-threshold', type=int, default=1, help='Minutes after which a detection is considered stale (default: 1)')
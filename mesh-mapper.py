@@ -8,8 +8,11 @@ import serial.tools.list_ports
 import time
 import csv
 import os
+import queue
+import struct
+from collections import deque
 from datetime import datetime
-from flask import Flask, request, jsonify, redirect, url_for, render_template_string, send_file
+from flask import Flask, Response, request, jsonify, redirect, url_for, render_template_string, send_file
 from requests.adapters import HTTPAdapter
 from urllib3.util.retry import Retry
 import zmq
@@ -27,10 +30,16 @@ app = Flask(__name__)
 # ----------------------
 tracked_pairs = {}
 detection_history = []  # For CSV logging and KML generation
+# Guards tracked_pairs, partial_pairs and detection_history; the ingest worker
+# writes them while Flask threads read them.
+tracked_pairs_lock = threading.RLock()
 
 # Changed: Instead of one selected port, we allow up to three.
 SELECTED_PORTS = {}  # key will be 'port1', 'port2', 'port3'
 BAUD_RATE = 115200
+# Asked of the firmware after connecting; it stays at BAUD_RATE if it cannot.
+# Native USB boards acknowledge without a real change.
+FAST_BAUD_RATE = 921600
 staleThreshold = 60  # Global stale threshold in seconds (changed from 300 seconds -> 1 minute)
 # For each port, we track its connection status.
 serial_connected_status = {}  # e.g. {"port1": True, "port2": False, ...}
@@ -41,11 +50,40 @@ last_mac_by_port = {}
 serial_objs = {}
 serial_objs_lock = threading.Lock()
 
+# Firmware stats records per port, for the node health charts
+NODE_STATS_HISTORY = 360  # An hour at the firmware's default 10 s interval
+node_stats = {}
+node_stats_lock = threading.Lock()
+
+# Node clocks. Each node is sent "TIME <unix_us>" on connect and every
+# TIME_SYNC_INTERVAL seconds (more precise with a GPS PPS wired to the node),
+# and stamps detections with rx_us, the frame's reception time: Unix
+# microseconds once synced, microseconds since boot before. Synced receptions
+# of one drone by several nodes within JOIN_WINDOW_US are joined into one
+# observation for RSSI or time-difference localization (/api/observations).
+# TIME also tells a node a host is listening, which stops its flash backlog.
+TIME_SYNC_INTERVAL = 10
+UNIX_US_MIN = 10 ** 15        # Smaller rx_us values count from the node's boot
+JOIN_WINDOW_US = 2000
+OBSERVATION_HISTORY = 500
+node_clocks = {}              # port -> latest {"time": {...}} record
+observations = deque(maxlen=OBSERVATION_HISTORY)
+open_observations = {}        # mac -> recent observations, newest last
+observations_lock = threading.Lock()
+
 startup_timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
 # Updated detections CSV header to include faa_data.
 CSV_FILENAME = os.path.join(BASE_DIR, f"detections_{startup_timestamp}.csv")
 KML_FILENAME = os.path.join(BASE_DIR, f"detections_{startup_timestamp}.kml")
 FAA_LOG_FILENAME = os.path.join(BASE_DIR, "faa_log.csv")  # FAA log CSV remains basic
+# Detections a node kept in flash while no host was connected, read back with
+# "DRAIN" on connect. They are history, so they go here and to the
+# observations rather than onto the live map.
+BACKLOG_CSV_FILENAME = os.path.join(BASE_DIR, f"backlog_{startup_timestamp}.csv")
+BACKLOG_FIELDS = [
+    'port', 'rx_us', 'mac', 'rssi', 'drone_lat', 'drone_long',
+    'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id'
+]
 
 # Write CSV header for detections.
 with open(CSV_FILENAME, mode='w', newline='') as csvfile:
@@ -84,34 +122,96 @@ def save_aliases():
 # ----------------------
 # FAA Cache Persistence
 # ----------------------
+# faa_cache.csv is append-only: a later row for the same (mac, remote_id)
+# replaces an earlier one. Lookups are by remote ID, so the cache is indexed
+# by remote ID and by MAC as well. Entries older than FAA_CACHE_TTL are still
+# shown but looked up again; an answer with no registrations is a negative
+# entry and expires after FAA_NEGATIVE_TTL.
 FAA_CACHE_FILE = os.path.join(BASE_DIR, "faa_cache.csv")
+FAA_CACHE_FIELDS = ["mac", "remote_id", "faa_response", "cached_at"]
+FAA_CACHE_TTL = 7 * 24 * 3600
+FAA_NEGATIVE_TTL = 6 * 3600
 FAA_CACHE = {}
-
-# Load FAA cache from file
-if os.path.exists(FAA_CACHE_FILE):
+FAA_BY_MAC = {}
+FAA_BY_REMOTE_ID = {}
+FAA_CACHED_AT = {}       # remote_id -> time of the answer in FAA_BY_REMOTE_ID
+
+def faa_has_items(faa_data):
+    return bool(faa_data and faa_data.get("data", {}).get("items"))
+
+def index_faa(mac, remote_id, faa_data, cached_at):
+    FAA_CACHE[(mac, remote_id)] = faa_data
+    # A negative answer does not hide a registration already known for the MAC
+    if faa_has_items(faa_data) or mac not in FAA_BY_MAC:
+        FAA_BY_MAC[mac] = faa_data
+    if remote_id:
+        FAA_BY_REMOTE_ID[remote_id] = faa_data
+        FAA_CACHED_AT[remote_id] = cached_at
+
+def lookup_faa(mac, remote_id):
+    """Cached FAA data: exact (mac, remote_id), then the remote ID on any MAC, then the MAC."""
+    if remote_id:
+        faa_data = FAA_CACHE.get((mac, remote_id)) or FAA_BY_REMOTE_ID.get(remote_id)
+        if faa_data:
+            return faa_data
+    return FAA_BY_MAC.get(mac)
+
+def faa_cache_fresh(remote_id):
+    if remote_id not in FAA_BY_REMOTE_ID:
+        return False
+    ttl = FAA_CACHE_TTL if faa_has_items(FAA_BY_REMOTE_ID[remote_id]) else FAA_NEGATIVE_TTL
+    return time.time() - FAA_CACHED_AT.get(remote_id, 0) < ttl
+
+def load_faa_cache():
+    rows = 0
     try:
+        # Rows from before the cached_at column count from the file's mtime
+        mtime = os.path.getmtime(FAA_CACHE_FILE)
         with open(FAA_CACHE_FILE, newline='') as csvfile:
             reader = csv.DictReader(csvfile)
+            current = "cached_at" in (reader.fieldnames or [])
             for row in reader:
-                key = (row['mac'], row['remote_id'])
-                FAA_CACHE[key] = json.loads(row['faa_response'])
+                rows += 1
+                cached_at = float(row.get("cached_at") or mtime)
+                index_faa(row['mac'], row['remote_id'], json.loads(row['faa_response']), cached_at)
     except Exception as e:
         print("Error loading FAA cache:", e)
+        return
+    # Rewrite one row per key when the header is old or replaced rows pile up
+    if not current or rows > 2 * len(FAA_CACHE):
+        try:
+            tmp = FAA_CACHE_FILE + ".tmp"
+            with open(tmp, "w", newline='') as csvfile:
+                writer = csv.DictWriter(csvfile, fieldnames=FAA_CACHE_FIELDS)
+                writer.writeheader()
+                for (mac, remote_id), faa_data in FAA_CACHE.items():
+                    writer.writerow({
+                        "mac": mac,
+                        "remote_id": remote_id,
+                        "faa_response": json.dumps(faa_data),
+                        "cached_at": FAA_CACHED_AT.get(remote_id, mtime)
+                    })
+            os.replace(tmp, FAA_CACHE_FILE)
+        except OSError as e:
+            print("Error compacting FAA cache:", e)
 
-def write_to_faa_cache(mac, remote_id, faa_data):
-    key = (mac, remote_id)
-    FAA_CACHE[key] = faa_data
+if os.path.exists(FAA_CACHE_FILE):
+    load_faa_cache()
+
+def write_to_faa_cache(mac, remote_id, faa_data, cached_at=None):
+    now = cached_at or time.time()
+    index_faa(mac, remote_id, faa_data, now)
     try:
         file_exists = os.path.isfile(FAA_CACHE_FILE)
         with open(FAA_CACHE_FILE, "a", newline='') as csvfile:
-            fieldnames = ["mac", "remote_id", "faa_response"]
-            writer = csv.DictWriter(csvfile, fieldnames=fieldnames)
+            writer = csv.DictWriter(csvfile, fieldnames=FAA_CACHE_FIELDS)
             if not file_exists:
                 writer.writeheader()
             writer.writerow({
                 "mac": mac,
                 "remote_id": remote_id,
-                "faa_response": json.dumps(faa_data)
+                "faa_response": json.dumps(faa_data),
+                "cached_at": now
             })
     except Exception as e:
         print("Error writing to FAA cache:", e)
@@ -126,7 +226,9 @@ def generate_kml():
         '<Document>',
         f'<name>Detections {startup_timestamp}</name>'
     ]
-    for mac, det in tracked_pairs.items():
+    with tracked_pairs_lock:
+        pairs = list(tracked_pairs.items())
+    for mac, det in pairs:
         remoteIdStr = ""
         if det.get("basic_id"):
             remoteIdStr = " (RemoteID: " + det.get("basic_id") + ")"
@@ -157,39 +259,46 @@ generate_kml()
 # ----------------------
 # Detection Update & CSV Logging
 # ----------------------
+# Firmware sends per-drone deltas: mac and rssi plus only the message groups
+# that changed. Drones heard without a position yet wait here until one arrives.
+partial_pairs = {}
+COORD_FIELDS = ('drone_lat', 'drone_long', 'pilot_lat', 'pilot_long')
+
+def merge_detection(mac, detection):
+    merged = dict(tracked_pairs.get(mac) or partial_pairs.get(mac) or {})
+    for key, value in detection.items():
+        # Older firmware reports coordinates it has not decoded as zero
+        if key in COORD_FIELDS and value == 0:
+            continue
+        merged[key] = value
+    return merged
+
 def update_detection(detection):
+    """Applies one (possibly folded) delta. Call with tracked_pairs_lock held.
+    Returns True if tracked_pairs changed."""
     mac = detection.get("mac")
     if not mac:
-        return
+        return False
 
-    # Retrieve new drone coordinates from the detection
+    delta_has_drone = (detection.get("drone_lat", 0) != 0 and detection.get("drone_long", 0) != 0)
+    detection = merge_detection(mac, detection)
     new_drone_lat = detection.get("drone_lat", 0)
     new_drone_long = detection.get("drone_long", 0)
     valid_drone = (new_drone_lat != 0 and new_drone_long != 0)
 
-    # If the new detection has invalid (0) drone coordinates...
     if not valid_drone:
-        # If there is an existing record with valid coordinates, update only non-coordinate fields.
-        if mac in tracked_pairs:
-            existing = tracked_pairs[mac]
-            if existing.get("drone_lat", 0) != 0 and existing.get("drone_long", 0) != 0:
-                # Update fields other than drone coordinates
-                for field in ['rssi', 'basic_id', 'drone_altitude']:
-                    if field in detection:
-                        existing[field] = detection[field]
-                # Update pilot coordinates only if they are valid (non zero)
-                new_pilot_lat = detection.get("pilot_lat", 0)
-                new_pilot_long = detection.get("pilot_long", 0)
-                if new_pilot_lat != 0:
-                    existing["pilot_lat"] = new_pilot_lat
-                if new_pilot_long != 0:
-                    existing["pilot_long"] = new_pilot_long
-                existing["last_update"] = time.time()
-                print(f"Ignored update for {mac} due to invalid drone coordinates, preserving previous valid coordinates.")
-                return
-        # No previous valid record exists: ignore the detection entirely.
-        print(f"Ignored detection for {mac} because drone coordinates are zero.")
-        return
+        # Keep what is known (Basic ID, operator, ...) until the first position
+        detection["last_update"] = time.time()
+        partial_pairs[mac] = detection
+        print(f"Holding detection for {mac} until drone coordinates arrive.")
+        return False
+    partial_pairs.pop(mac, None)
+
+    if not delta_has_drone and mac in tracked_pairs:
+        # Nothing new to plot or log; refresh the non-position fields in place
+        detection["last_update"] = time.time()
+        tracked_pairs[mac] = detection
+        return True
 
     # Otherwise, use the provided non-zero coordinates.
     detection["drone_lat"] = new_drone_lat
@@ -200,44 +309,153 @@ def update_detection(detection):
     detection["last_update"] = time.time()
 
     remote_id = detection.get("basic_id")
-    # Try exact cache lookup by (mac, remote_id), then fallback to any cached data for this mac, then to previous tracked_pairs entry
+    # Cached FAA data by (mac, remote_id), remote ID or MAC, then the previous tracked_pairs entry
     if mac:
-        # Exact match if basic_id provided
-        if remote_id:
-            key = (mac, remote_id)
-            if key in FAA_CACHE:
-                detection["faa_data"] = FAA_CACHE[key]
-        # Fallback: any cached FAA data for this mac
-        if "faa_data" not in detection:
-            for (c_mac, _), faa_data in FAA_CACHE.items():
-                if c_mac == mac:
-                    detection["faa_data"] = faa_data
-                    break
+        faa_data = lookup_faa(mac, remote_id)
+        if faa_data:
+            detection["faa_data"] = faa_data
+        # Queue a lookup for an ID not in the cache or due again; never waits on it
+        if remote_id and FAA_AUTO_LOOKUP and faa_lookup_due(remote_id):
+            request_faa_lookup(mac, remote_id)
         # Fallback: last known FAA data in tracked_pairs
         if "faa_data" not in detection and mac in tracked_pairs and "faa_data" in tracked_pairs[mac]:
             detection["faa_data"] = tracked_pairs[mac]["faa_data"]
 
     tracked_pairs[mac] = detection
     detection_history.append(detection.copy())
-    print("Updated tracked_pairs:", tracked_pairs)
+    csv_pending.append({
+        'timestamp': datetime.now().isoformat(),
+        'mac': mac,
+        'rssi': detection.get('rssi', ''),
+        'drone_lat': detection.get('drone_lat', ''),
+        'drone_long': detection.get('drone_long', ''),
+        'drone_altitude': detection.get('drone_altitude', ''),
+        'pilot_lat': detection.get('pilot_lat', ''),
+        'pilot_long': detection.get('pilot_long', ''),
+        'basic_id': detection.get('basic_id', ''),
+        'faa_data': json.dumps(detection.get('faa_data', {}))
+    })
+    return True
+
+# ----------------------
+# Ingest Pipeline
+# ----------------------
+# Serial readers and POST /api/detections only parse and queue. One worker
+# drains the queue once per INGEST_TICK, folds the deltas of each drone into
+# one, applies them under the lock, appends the CSV rows in a single write
+# and pushes the drones that changed to /api/stream clients. The KML file is
+# rewritten at most every KML_WRITE_INTERVAL seconds.
+INGEST_TICK = 0.2
+INGEST_QUEUE_MAX = 10000
+KML_WRITE_INTERVAL = 5.0
+STREAM_CLIENT_BACKLOG = 256   # Undelivered pushes before a client is made to reconnect
+STREAM_KEEPALIVE = 15
+
+ingest_queue = queue.Queue(maxsize=INGEST_QUEUE_MAX)
+ingest_dropped = 0
+csv_pending = []              # Rows due for the CSV, written by the worker
+kml_dirty = False
+stream_clients = []
+stream_clients_lock = threading.Lock()
+
+def submit_detection(detection):
+    global ingest_dropped
+    try:
+        ingest_queue.put_nowait(detection)
+    except queue.Full:
+        ingest_dropped += 1
+        if ingest_dropped % 1000 == 1:
+            print(f"Ingest queue full; {ingest_dropped} detections dropped so far.")
+
+def fold_delta(folded, delta):
+    """Later deltas of one drone win, except coordinates reported as zero."""
+    for key, value in delta.items():
+        if key in COORD_FIELDS and value == 0:
+            continue
+        folded[key] = value
+    return folded
+
+def flush_csv():
+    with tracked_pairs_lock:
+        rows = csv_pending[:]
+        del csv_pending[:]
+    if not rows:
+        return
     with open(CSV_FILENAME, mode='a', newline='') as csvfile:
         writer = csv.DictWriter(csvfile, fieldnames=[
             'timestamp', 'mac', 'rssi', 'drone_lat', 'drone_long',
             'drone_altitude', 'pilot_lat', 'pilot_long', 'basic_id', 'faa_data'
         ])
-        writer.writerow({
-            'timestamp': datetime.now().isoformat(),
-            'mac': mac,
-            'rssi': detection.get('rssi', ''),
-            'drone_lat': detection.get('drone_lat', ''),
-            'drone_long': detection.get('drone_long', ''),
-            'drone_altitude': detection.get('drone_altitude', ''),
-            'pilot_lat': detection.get('pilot_lat', ''),
-            'pilot_long': detection.get('pilot_long', ''),
-            'basic_id': detection.get('basic_id', ''),
-            'faa_data': json.dumps(detection.get('faa_data', {}))
-        })
-    generate_kml()
+        writer.writerows(rows)
+
+def drop_stream_client(client):
+    """Empties a stalled client's queue and ends its stream; the browser
+    reconnects and starts again from a snapshot."""
+    with stream_clients_lock:
+        if client in stream_clients:
+            stream_clients.remove(client)
+    try:
+        while True:
+            client.get_nowait()
+    except queue.Empty:
+        pass
+    client.put_nowait(None)
+
+def publish_detections(changes):
+    """Pushes {mac: record} to every /api/stream client."""
+    global kml_dirty
+    if not changes:
+        return
+    kml_dirty = True
+    message = json.dumps({"detections": changes})
+    with stream_clients_lock:
+        clients = list(stream_clients)
+    for client in clients:
+        try:
+            client.put_nowait(message)
+        except queue.Full:
+            drop_stream_client(client)
+
+def ingest_worker():
+    global kml_dirty
+    last_kml = time.time()
+    while True:
+        batch = {}
+        try:
+            first = ingest_queue.get(timeout=INGEST_TICK)
+        except queue.Empty:
+            first = None
+        if first is not None:
+            # Let the rest of this tick arrive, then take everything queued
+            time.sleep(INGEST_TICK)
+            items = [first]
+            try:
+                while True:
+                    items.append(ingest_queue.get_nowait())
+            except queue.Empty:
+                pass
+            for item in items:
+                mac = item.get("mac")
+                if mac:
+                    fold_delta(batch.setdefault(mac, {}), item)
+        if batch:
+            with tracked_pairs_lock:
+                changed = [mac for mac, delta in batch.items() if update_detection(delta)]
+                changes = {mac: dict(tracked_pairs[mac]) for mac in changed}
+            try:
+                flush_csv()
+            except OSError as e:
+                print("Error writing detections CSV:", e)
+            publish_detections(changes)
+        if kml_dirty and time.time() - last_kml >= KML_WRITE_INTERVAL:
+            kml_dirty = False
+            last_kml = time.time()
+            try:
+                generate_kml()
+            except OSError as e:
+                print("Error writing KML:", e)
+
+threading.Thread(target=ingest_worker, daemon=True).start()
 
 # ----------------------
 # Global Follow Lock & Color Overrides
@@ -302,40 +520,134 @@ def query_remote_id(session, remote_id):
         return None
 
 # ----------------------
-# New FAA Query API Endpoint
+# FAA Lookup Worker
 # ----------------------
-@app.route('/api/query_faa', methods=['POST'])
-def api_query_faa():
-    data = request.get_json()
-    mac = data.get("mac")
-    remote_id = data.get("remote_id")
-    if not mac or not remote_id:
-        return jsonify({"status": "error", "message": "Missing mac or remote_id"}), 400
-    session = create_retry_session()
-    refresh_cookie(session)
-    faa_result = query_remote_id(session, remote_id)
-    if faa_result is None:
-        return jsonify({"status": "error", "message": "FAA query failed"}), 500
-    if mac in tracked_pairs:
-        tracked_pairs[mac]["faa_data"] = faa_result
-    else:
-        tracked_pairs[mac] = {"basic_id": remote_id, "faa_data": faa_result}
-    write_to_faa_cache(mac, remote_id, faa_result)
-    timestamp = datetime.now().isoformat()
+# Lookups run on one thread so ingest never waits on uasdoc.faa.gov. Requests
+# queue by remote ID; a remote ID already queued or in flight is not queued
+# again, only the MAC is added to the ones its answer goes to. The worker
+# keeps one session and its cookie, starting a new one after a failure, and
+# leaves at least FAA_MIN_INTERVAL seconds between queries. A failed query is
+# not cached; the same remote ID is not queued again on its own for
+# FAA_FAILURE_BACKOFF seconds.
+FAA_AUTO_LOOKUP = False         # True looks up every new remote ID as it is seen
+FAA_LOOKUP_QUEUE_SIZE = 64      # Remote IDs waiting; a full queue drops the request
+FAA_MIN_INTERVAL = 2.0
+FAA_FAILURE_BACKOFF = 300
+FAA_API_WAIT = 10.0             # POST /api/query_faa answers "pending" after this
+
+faa_lookup_queue = queue.Queue(maxsize=FAA_LOOKUP_QUEUE_SIZE)
+faa_lookup_lock = threading.Lock()
+faa_pending = {}                # remote_id -> {"macs", "event", "result"}
+faa_failed_until = {}           # remote_id -> time before which it is not retried
+
+def faa_lookup_due(remote_id):
+    with faa_lookup_lock:
+        if remote_id in faa_pending or time.time() < faa_failed_until.get(remote_id, 0):
+            return False
+    return not faa_cache_fresh(remote_id)
+
+def request_faa_lookup(mac, remote_id):
+    """Queues a lookup of remote_id for mac. Returns its pending entry, None if the queue is full."""
+    with faa_lookup_lock:
+        pending = faa_pending.get(remote_id)
+        if pending:
+            pending["macs"].add(mac)
+            return pending
+        pending = {"macs": {mac}, "event": threading.Event(), "result": None}
+        try:
+            faa_lookup_queue.put_nowait(remote_id)
+        except queue.Full:
+            return None
+        faa_pending[remote_id] = pending
+        return pending
+
+def log_faa_result(mac, remote_id, faa_result):
     try:
         with open(FAA_LOG_FILENAME, "a", newline='') as csvfile:
             fieldnames = ["timestamp", "mac", "remote_id", "faa_response"]
             writer = csv.DictWriter(csvfile, fieldnames=fieldnames)
             writer.writerow({
-                "timestamp": timestamp,
+                "timestamp": datetime.now().isoformat(),
                 "mac": mac,
                 "remote_id": remote_id,
                 "faa_response": json.dumps(faa_result)
             })
     except Exception as e:
         print("Error writing to FAA log CSV:", e)
-    generate_kml()
-    return jsonify({"status": "ok", "faa_data": faa_result})
+
+def apply_faa_result(remote_id, macs, faa_result, cached_at=None):
+    """Caches an answer and pushes it to the drones it was asked for."""
+    changes = {}
+    with tracked_pairs_lock:
+        for mac in macs:
+            write_to_faa_cache(mac, remote_id, faa_result, cached_at)
+            record = tracked_pairs.get(mac)
+            if record is None:
+                tracked_pairs[mac] = {"basic_id": remote_id, "faa_data": faa_result}
+            elif faa_has_items(faa_result) or not faa_has_items(record.get("faa_data")):
+                record["faa_data"] = faa_result
+            changes[mac] = dict(tracked_pairs[mac])
+    publish_detections(changes)
+    for mac in macs:
+        log_faa_result(mac, remote_id, faa_result)
+
+def faa_lookup_worker():
+    session = None
+    last_query = 0
+    while True:
+        remote_id = faa_lookup_queue.get()
+        wait = FAA_MIN_INTERVAL - (time.time() - last_query)
+        if wait > 0:
+            time.sleep(wait)
+        if session is None:
+            session = create_retry_session()
+            refresh_cookie(session)
+        last_query = time.time()
+        faa_result = query_remote_id(session, remote_id)
+        with faa_lookup_lock:
+            pending = faa_pending.pop(remote_id)
+            if faa_result is None:
+                faa_failed_until[remote_id] = time.time() + FAA_FAILURE_BACKOFF
+            else:
+                faa_failed_until.pop(remote_id, None)
+        if faa_result is None:
+            session = None
+        else:
+            try:
+                apply_faa_result(remote_id, pending["macs"], faa_result)
+            except Exception as e:
+                logging.exception("Error applying FAA result: %s", e)
+        pending["result"] = faa_result
+        pending["event"].set()
+
+threading.Thread(target=faa_lookup_worker, daemon=True).start()
+
+# ----------------------
+# New FAA Query API Endpoint
+# ----------------------
+# A fresh cache entry answers at once. Otherwise the lookup is queued (or
+# joined, if already queued) and waited on for FAA_API_WAIT seconds; past that
+# the answer is "pending" and the result reaches the map through /api/stream.
+@app.route('/api/query_faa', methods=['POST'])
+def api_query_faa():
+    data = request.get_json()
+    mac = data.get("mac")
+    remote_id = data.get("remote_id")
+    if not mac or not remote_id:
+        return jsonify({"status": "error", "message": "Missing mac or remote_id"}), 400
+    if faa_cache_fresh(remote_id):
+        faa_result = FAA_BY_REMOTE_ID[remote_id]
+        if FAA_CACHE.get((mac, remote_id)) != faa_result:
+            apply_faa_result(remote_id, [mac], faa_result, FAA_CACHED_AT.get(remote_id))
+        return jsonify({"status": "ok", "faa_data": faa_result})
+    pending = request_faa_lookup(mac, remote_id)
+    if pending is None:
+        return jsonify({"status": "error", "message": "FAA lookup queue full"}), 503
+    if not pending["event"].wait(FAA_API_WAIT):
+        return jsonify({"status": "pending", "message": "FAA lookup queued"}), 202
+    if pending["result"] is None:
+        return jsonify({"status": "error", "message": "FAA query failed"}), 500
+    return jsonify({"status": "ok", "faa_data": pending["result"]})
 
 # ----------------------
 # HTML & JS (UI) Section
@@ -592,6 +904,8 @@ HTML_PAGE = '''
       z-index: 1000;
     }
     #serialStatus div { margin-bottom: 5px; }
+    .node-stats { color: lime; font-size: 0.9em; }
+    .node-stats canvas { display: block; border: 0.5px solid #333; }
     /* Remove extra bottom padding from the last USB item */
     #serialStatus div:last-child { margin-bottom: 0; }
     
@@ -1014,8 +1328,8 @@ document.addEventListener('DOMContentLoaded', () => {
       if (popupSwitch) popupSwitch.checked = enabled;
     };
   }
-  // Start polling based on current setting
-  updateData();
+  // Updates are pushed; the interval only re-checks staleness
+  startDetectionStream();
   updateDataInterval = setInterval(updateData, mainSwitch && mainSwitch.checked ? 1000 : 200);
 
   // ZMQ Settings
@@ -1357,6 +1671,12 @@ async function queryFaaAPI(mac, remote_id) {
                   faaDiv.innerHTML = '<div style="border:2px solid #FF69B4; padding:5px; margin:5px 0;">No FAA data available</div>';
                 }
             }
+        } else if (result.status === "pending") {
+            // The answer arrives with the drone's next /api/stream update
+            const faaDiv = document.getElementById("faaResult_" + mac);
+            if (faaDiv) {
+                faaDiv.innerHTML = '<div style="border:2px solid #FF69B4; padding:5px; margin:5px 0;">FAA lookup queued</div>';
+            }
         } else {
             alert("FAA API error: " + result.message);
         }
@@ -1777,10 +2097,24 @@ function updateComboList(data) {
   });
 }
 
+// Detections are pushed on /api/stream: a snapshot first, then only the
+// drones that changed. EventSource reconnects by itself and gets a new snapshot.
+let detectionsCache = {};
+function startDetectionStream() {
+  const source = new EventSource('/api/stream');
+  source.onmessage = (event) => {
+    const message = JSON.parse(event.data);
+    if (message.snapshot) { detectionsCache = {}; }
+    Object.assign(detectionsCache, message.detections);
+    updateData();
+  };
+  source.onerror = () => { console.error("Detection stream interrupted; reconnecting."); };
+}
+
+// Redraws from the pushed detections; also run on a timer so stale drones age out.
 async function updateData() {
   try {
-    const response = await fetch('/api/detections');
-    const data = await response.json();
+    const data = detectionsCache;
     window.tracked_pairs = data;
     // Persist current detection data to localStorage so that markers & paths remain on reload.
     localStorage.setItem("trackedPairs", JSON.stringify(data));
@@ -1931,6 +2265,56 @@ function getDynamicSize() {
   return base * 1.15;
 }
 
+// Firmware stats records per port; charted under each port's status.
+let nodeStatsCache = {};
+async function updateNodeStats() {
+  try {
+    const response = await fetch('/api/node_stats');
+    nodeStatsCache = await response.json();
+  } catch (error) { console.error("Error fetching node stats:", error); }
+}
+setInterval(updateNodeStats, 5000);
+updateNodeStats();
+
+// Frames/s in lime and p90 capture-to-serial latency in pink, each scaled to its own peak.
+function drawNodeStats(canvas, records) {
+  const ctx = canvas.getContext('2d');
+  const w = canvas.width, h = canvas.height;
+  ctx.clearRect(0, 0, w, h);
+  if (records.length < 2) return;
+  const series = [
+    { key: 'fps', color: 'lime' },
+    { key: 'latency_p90_ms', color: '#FF00FF' },
+  ];
+  for (const s of series) {
+    const values = records.map(r => r[s.key] || 0);
+    const peak = Math.max(...values, 1);
+    ctx.strokeStyle = s.color;
+    ctx.beginPath();
+    values.forEach((v, i) => {
+      const x = i * (w - 1) / (values.length - 1);
+      const y = h - 1 - v * (h - 2) / peak;
+      if (i === 0) ctx.moveTo(x, y); else ctx.lineTo(x, y);
+    });
+    ctx.stroke();
+  }
+}
+
+function nodeStatsElement(records) {
+  const last = records[records.length - 1];
+  const drops = (last.ring_full_drops || 0) + (last.ring_oversize_drops || 0) + (last.mesh_dropped || 0);
+  const div = document.createElement("div");
+  div.className = 'node-stats';
+  div.textContent = last.fps + ' fps, p90 ' + (last.latency_p90_ms === null ? '-' : last.latency_p90_ms + ' ms') +
+    ', ring ' + last.ring_depth + '/' + last.ring_high_water + ', drops ' + drops;
+  const canvas = document.createElement("canvas");
+  canvas.width = 160;
+  canvas.height = 30;
+  div.appendChild(canvas);
+  drawNodeStats(canvas, records.slice(-60));
+  return div;
+}
+
 // Updated function: now updates all selected USB port statuses.
 async function updateSerialStatus() {
   try {
@@ -1945,6 +2329,8 @@ async function updateSerialStatus() {
         div.innerHTML = '<span class="usb-name">' + port + '</span>: ' +
           (data.statuses[port] ? '<span style="color: lime;">Connected</span>' : '<span style="color: red;">Disconnected</span>');
         statusDiv.appendChild(div);
+        const records = nodeStatsCache[port];
+        if (records && records.length) statusDiv.appendChild(nodeStatsElement(records));
       }
     }
   } catch (error) { console.error("Error fetching serial status:", error); }
@@ -2160,18 +2546,52 @@ def index():
 
 @app.route('/api/detections', methods=['GET'])
 def api_detections():
-    return jsonify(tracked_pairs)
+    with tracked_pairs_lock:
+        return jsonify(tracked_pairs)
 
 @app.route('/api/detections', methods=['POST'])
 def post_detection():
     detection = request.get_json()
-    update_detection(detection)
+    submit_detection(detection)
     return jsonify({"status": "ok"}), 200
 
+# Server-sent events: a snapshot of every drone on connect, then a
+# {"detections": {mac: record}} message per ingest tick with the drones that
+# changed. Clients merge the records into what they have.
+@app.route('/api/stream')
+def api_stream():
+    client = queue.Queue(maxsize=STREAM_CLIENT_BACKLOG)
+    with stream_clients_lock:
+        stream_clients.append(client)
+    with tracked_pairs_lock:
+        snapshot = json.dumps({"detections": tracked_pairs, "snapshot": True})
+
+    def events():
+        try:
+            yield f"data: {snapshot}\n\n"
+            while True:
+                try:
+                    message = client.get(timeout=STREAM_KEEPALIVE)
+                except queue.Empty:
+                    yield ": keepalive\n\n"
+                    continue
+                if message is None:
+                    break
+                yield f"data: {message}\n\n"
+        finally:
+            with stream_clients_lock:
+                if client in stream_clients:
+                    stream_clients.remove(client)
+
+    return Response(events(), mimetype='text/event-stream',
+                    headers={'Cache-Control': 'no-cache', 'X-Accel-Buffering': 'no'})
+
 @app.route('/api/detections_history', methods=['GET'])
 def api_detections_history():
     features = []
-    for det in detection_history:
+    with tracked_pairs_lock:
+        history = list(detection_history)
+    for det in history:
         if det.get("drone_lat", 0) == 0 and det.get("drone_long", 0) == 0:
             continue
         features.append({
@@ -2194,8 +2614,13 @@ def api_detections_history():
 
 @app.route('/api/reactivate/<mac>', methods=['POST'])
 def reactivate(mac):
-    if mac in tracked_pairs:
-        tracked_pairs[mac]['last_update'] = time.time()
+    with tracked_pairs_lock:
+        record = tracked_pairs.get(mac)
+        if record:
+            record['last_update'] = time.time()
+            record = dict(record)
+    if record:
+        publish_detections({mac: record})
         print(f"Reactivated {mac}")
         return jsonify({"status": "reactivated", "mac": mac})
     else:
@@ -2237,11 +2662,25 @@ def api_ports():
 def api_serial_status():
     return jsonify({"statuses": serial_connected_status})
 
+@app.route('/api/node_stats', methods=['GET'])
+def api_node_stats():
+    with node_stats_lock:
+        return jsonify({port: list(records) for port, records in node_stats.items()})
+
+@app.route('/api/observations', methods=['GET'])
+def api_observations():
+    """Receptions of one frame by two or more nodes, newest first, with each node's clock."""
+    with observations_lock:
+        joined = [dict(obs, nodes=dict(obs['nodes'])) for obs in reversed(observations)]
+    return jsonify({"clocks": node_clocks, "join_window_us": JOIN_WINDOW_US, "observations": joined})
+
 @app.route('/api/paths', methods=['GET'])
 def api_paths():
     drone_paths = {}
     pilot_paths = {}
-    for det in detection_history:
+    with tracked_pairs_lock:
+        history = list(detection_history)
+    for det in history:
         mac = det.get("mac")
         if not mac:
             continue
@@ -2265,6 +2704,156 @@ def api_paths():
     for mac in pilot_paths: pilot_paths[mac] = dedupe(pilot_paths[mac])
     return jsonify({"dronePaths": drone_paths, "pilotPaths": pilot_paths})
 
+# ----------------------
+# Binary Detection Frames
+# ----------------------
+# Firmware switched to binary output ("OUTPUT BINARY") sends each detection as
+#   0xA5 0x5A | type | len | payload | crc16 (CRC-16/CCITT-FALSE, little endian)
+# between its ordinary text lines. See detection_frame.h for the payload layout.
+FRAME_SYNC = b'\xa5\x5a'
+FRAME_TYPE_DETECTION = 0x01
+FRAME_TYPE_STORED = 0x02      # A detection from the node's flash backlog
+MAX_TEXT_BUFFER = 4096
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+def decode_detection_payload(payload):
+    if len(payload) < 7:
+        return None
+    detection = {
+        "mac": ":".join(f"{b:02x}" for b in payload[:6]),
+        "rssi": struct.unpack_from('<b', payload, 6)[0],
+    }
+    pos = 7
+    while pos + 2 <= len(payload):
+        tag, size = payload[pos], payload[pos + 1]
+        body = payload[pos + 2:pos + 2 + size]
+        pos += 2 + size
+        if len(body) != size:
+            break
+        if tag == 0 and size >= 1:    # Basic ID
+            detection["ua_type"] = body[0]
+            detection["basic_id"] = body[1:].decode('ascii', errors='ignore')
+        elif tag == 1 and size >= 10:  # Location
+            lat, lon, alt = struct.unpack_from('<iih', body)
+            detection["drone_lat"] = lat / 1e7
+            detection["drone_long"] = lon / 1e7
+            detection["drone_altitude"] = alt
+        elif tag == 2 and size >= 4:   # Auth
+            auth_type, last_page, pages = struct.unpack_from('<BBH', body)
+            detection["auth_type"] = auth_type
+            detection["auth_last_page"] = last_page
+            detection["auth_pages"] = pages
+        elif tag == 3:                 # Self ID
+            detection["description"] = body.decode('ascii', errors='ignore')
+        elif tag == 4 and size >= 8:   # System
+            lat, lon = struct.unpack_from('<ii', body)
+            detection["pilot_lat"] = lat / 1e7
+            detection["pilot_long"] = lon / 1e7
+        elif tag == 5:                 # Operator ID
+            detection["operator_id"] = body.decode('ascii', errors='ignore')
+        elif tag == 8 and size >= 8:   # RX time
+            detection["rx_us"] = struct.unpack_from('<Q', body)[0]
+    return detection
+
+def latency_percentile(bounds, counts, q):
+    """Upper bound (ms) of the histogram bucket holding the q quantile, None when empty."""
+    total = sum(counts)
+    if not total:
+        return None
+    seen = 0
+    for i, count in enumerate(counts):
+        seen += count
+        if seen >= q * total:
+            # The last bucket is open-ended; report it as twice the largest bound
+            return bounds[i] if i < len(bounds) else (bounds[-1] * 2 if bounds else None)
+    return None
+
+def record_node_stats(port, stats):
+    bounds = stats.get('latency_bounds_ms', [])
+    counts = stats.get('latency', [])
+    stats['time'] = time.time()
+    stats['latency_p50_ms'] = latency_percentile(bounds, counts, 0.5)
+    stats['latency_p90_ms'] = latency_percentile(bounds, counts, 0.9)
+    with node_stats_lock:
+        node_stats.setdefault(port, deque(maxlen=NODE_STATS_HISTORY)).append(stats)
+
+def record_observation(port, detection):
+    """Joins a synced reception with those of the same drone by other nodes."""
+    rx_us = detection.get('rx_us', 0)
+    mac = detection.get('mac')
+    if not mac or rx_us < UNIX_US_MIN:
+        return
+    reception = {"rssi": detection.get('rssi'), "rx_us": rx_us}
+    with observations_lock:
+        recent = open_observations.setdefault(mac, deque(maxlen=8))
+        for obs in reversed(recent):
+            if abs(rx_us - obs['rx_us']) <= JOIN_WINDOW_US and port not in obs['nodes']:
+                obs['nodes'][port] = reception
+                if len(obs['nodes']) == 2:
+                    observations.append(obs)
+                return
+        recent.append({"mac": mac, "rx_us": rx_us, "nodes": {port: reception}})
+
+def write_backlog(port, detections):
+    if not detections:
+        return
+    new_file = not os.path.exists(BACKLOG_CSV_FILENAME)
+    with open(BACKLOG_CSV_FILENAME, mode='a', newline='') as csvfile:
+        writer = csv.DictWriter(csvfile, fieldnames=BACKLOG_FIELDS, extrasaction='ignore')
+        if new_file:
+            writer.writeheader()
+        for detection in detections:
+            writer.writerow(dict(detection, port=port))
+
+class SerialStreamDecoder:
+    """Splits raw serial bytes into text lines (str) and binary detections (dict)."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        messages = []
+        while self.buffer:
+            sync = self.buffer.find(FRAME_SYNC)
+            newline = self.buffer.find(b'\n')
+            if newline != -1 and (sync == -1 or newline < sync):
+                messages.append(self.buffer[:newline].decode('utf-8', errors='ignore'))
+                del self.buffer[:newline + 1]
+                continue
+            if sync == -1:
+                # Wait for the rest of the line, keeping a byte that may start a frame
+                if len(self.buffer) > MAX_TEXT_BUFFER:
+                    del self.buffer[:-1]
+                break
+            if sync > 0:
+                messages.append(self.buffer[:sync].decode('utf-8', errors='ignore'))
+                del self.buffer[:sync]
+            if len(self.buffer) < 4:
+                break
+            total = 4 + self.buffer[3] + 2
+            if len(self.buffer) < total:
+                break
+            frame = bytes(self.buffer[:total])
+            if frame[2] not in (FRAME_TYPE_DETECTION, FRAME_TYPE_STORED) or \
+                    crc16_ccitt(frame[2:-2]) != int.from_bytes(frame[-2:], 'little'):
+                del self.buffer[:1]  # Not a frame after all; resync on the next sync bytes
+                continue
+            del self.buffer[:total]
+            detection = decode_detection_payload(frame[4:-2])
+            if detection:
+                if frame[2] == FRAME_TYPE_STORED:
+                    detection["backlog"] = True
+                messages.append(detection)
+        return messages
+
 # ----------------------
 # Serial Reader Threads: Each selected port gets its own thread.
 # ----------------------
@@ -2277,8 +2866,15 @@ def serial_reader(port):
                 ser = serial.Serial(port, BAUD_RATE, timeout=1)
                 serial_connected_status[port] = True
                 print(f"Opened serial port {port} at {BAUD_RATE} baud.")
+                decoder = SerialStreamDecoder()
                 with serial_objs_lock:
                     serial_objs[port] = ser
+                if FAST_BAUD_RATE > BAUD_RATE:
+                    ser.write(f"BAUD {FAST_BAUD_RATE}\n".encode())
+                # After the baud switch settles, or at once at a fixed rate
+                next_time_sync = time.time() + (3 if FAST_BAUD_RATE > BAUD_RATE else 0)
+                drain_due = True
+                backlog = []
             except Exception as e:
                 serial_connected_status[port] = False
                 print(f"Error opening serial port {port}: {e}")
@@ -2286,30 +2882,69 @@ def serial_reader(port):
                 continue
 
         try:
+            if time.time() >= next_time_sync:
+                ser.write(f"TIME {time.time_ns() // 1000}\n".encode())
+                next_time_sync = time.time() + TIME_SYNC_INTERVAL
+                if drain_due:
+                    ser.write(b"DRAIN\n")
+                    drain_due = False
             # Read incoming data
             if ser.in_waiting:
-                line = ser.readline().decode('utf-8', errors='ignore').strip()
-                if not line:
-                    continue
-                # JSON extraction and detection handling...
-                if '{' in line:
-                    json_str = line[line.find('{'):]
-                else:
-                    json_str = line
-                try:
-                    detection = json.loads(json_str)
-                    # MAC tracking logic...
-                    if 'mac' in detection:
+                for message in decoder.feed(ser.read(ser.in_waiting)):
+                    if isinstance(message, dict):
+                        detection = message
                         last_mac_by_port[port] = detection['mac']
-                    elif port in last_mac_by_port:
-                        detection['mac'] = last_mac_by_port[port]
-                except json.JSONDecodeError:
-                    continue
-                if 'remote_id' in detection and 'basic_id' not in detection:
-                    detection['basic_id'] = detection['remote_id']
-                if 'heartbeat' in detection:
-                    continue
-                update_detection(detection)
+                    else:
+                        line = message.strip()
+                        if not line:
+                            continue
+                        # JSON extraction and detection handling...
+                        if '{' in line:
+                            json_str = line[line.find('{'):]
+                        else:
+                            json_str = line
+                        try:
+                            detection = json.loads(json_str)
+                            # MAC tracking logic...
+                            if 'mac' in detection:
+                                last_mac_by_port[port] = detection['mac']
+                            elif port in last_mac_by_port:
+                                detection['mac'] = last_mac_by_port[port]
+                        except json.JSONDecodeError:
+                            continue
+                    if 'remote_id' in detection and 'basic_id' not in detection:
+                        detection['basic_id'] = detection['remote_id']
+                    if 'stats' in detection:
+                        record_node_stats(port, detection['stats'])
+                        continue
+                    if 'baud' in detection:
+                        # The firmware switched after this ack; follow and confirm in time
+                        if 'error' not in detection and detection['baud'] != ser.baudrate:
+                            ser.baudrate = detection['baud']
+                            ser.write(b"BAUD OK\n")
+                            print(f"{port} now at {ser.baudrate} baud.")
+                            next_time_sync = 0
+                        continue
+                    if 'time' in detection:
+                        node_clocks[port] = detection['time']
+                        continue
+                    if 'drain' in detection:
+                        # Saved first, so a confirmed backlog is never lost
+                        end = detection['drain'].get('end') if isinstance(detection['drain'], dict) else None
+                        if end is not None:
+                            write_backlog(port, backlog)
+                            print(f"{port}: {len(backlog)} backlog detections saved.")
+                            backlog = []
+                            ser.write(f"DRAIN OK {end}\n".encode())
+                        continue
+                    if detection.get('backlog'):
+                        backlog.append(detection)
+                        record_observation(port, detection)
+                        continue
+                    if 'heartbeat' in detection or 'output' in detection or 'tasks' in detection or 'records' in detection:
+                        continue
+                    record_observation(port, detection)
+                    submit_detection(detection)
             else:
                 time.sleep(0.1)
         except (serial.SerialException, OSError) as e:
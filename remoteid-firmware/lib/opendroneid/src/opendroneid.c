@@ -151,6 +151,22 @@ void odid_initUasData(ODID_UAS_Data *data)
     odid_initOperatorIDData(&data->OperatorID);
 }
 
+/**
+* Prepare lean data for decoding
+*
+* Only the Valid flags and the auth page set are cleared; the other fields
+* are only read for the message types flagged in Valid.
+*
+* @param data Lean data structure
+*/
+void odid_initLeanData(ODID_Lean_data *data)
+{
+    if (!data)
+        return;
+    data->Valid = 0;
+    data->AuthPages = 0;
+}
+
 /**
 * Encode direction as defined by Open Drone ID
 *
@@ -568,10 +584,7 @@ int encodeMessagePack(ODID_MessagePack_encoded *outEncoded, ODID_MessagePack_dat
 */
 static float decodeDirection(uint8_t Direction_enc, uint8_t EWDirection)
 {
-    if (EWDirection)
-        return (float) Direction_enc + 180;
-    else
-        return (float) Direction_enc;
+    return (float) (Direction_enc + (EWDirection ? 180 : 0));
 }
 
 /**
@@ -583,10 +596,9 @@ static float decodeDirection(uint8_t Direction_enc, uint8_t EWDirection)
 */
 static float decodeSpeedHorizontal(uint8_t Speed_enc, uint8_t mult)
 {
-    if (mult)
-        return ((float) Speed_enc * SPEED_DIV[1]) + (UINT8_MAX * SPEED_DIV[0]);
-    else
-        return (float) Speed_enc * SPEED_DIV[0];
+    // In 0.25 m/s steps; each high range step is three of them
+    int quarters = mult ? Speed_enc * 3 + UINT8_MAX : Speed_enc;
+    return (float) quarters * SPEED_DIV[0];
 }
 
 /**
@@ -619,7 +631,7 @@ static double decodeLatLon(int32_t LatLon_enc)
 */
 static float decodeAltitude(uint16_t Alt_enc)
 {
-    return (float) Alt_enc * ALT_DIV - (float) ALT_ADDER;
+    return (float) ((int) Alt_enc - 2 * ALT_ADDER) * ALT_DIV;
 }
 
 /**
@@ -1006,6 +1018,183 @@ ODID_messagetype_t decodeOpenDroneID(ODID_UAS_Data *uasData, uint8_t *msgData)
     return ODID_MESSAGETYPE_INVALID;
 }
 
+/**
+* Decode altitude in meters from ODID packed format without floats
+*
+* Truncates toward zero, matching (int) decodeAltitude().
+*
+* @param Alt_enc Encoded Altitude to decode
+* @return decoded Altitude (in meters)
+*/
+static int16_t decodeAltitudeLean(uint16_t Alt_enc)
+{
+    return (int16_t) (((int32_t) Alt_enc - 2 * ALT_ADDER) / 2);
+}
+
+/**
+* Decode one message into lean data
+*
+* Same validation as the full decoders, but only the fields of ODID_Lean_data
+* are produced, in fixed point, and nothing else is copied.
+*
+* @param leanData Output: lean data, Valid bit set for the decoded type
+* @param msgData  Pointer to a full ODID_MESSAGE_SIZE byte encoded message
+* @param type     The message type, from decodeMessageType()
+* @return         ODID_SUCCESS or ODID_FAIL;
+*/
+static int decodeMessageLean(ODID_Lean_data *leanData, const uint8_t *msgData,
+                             ODID_messagetype_t type)
+{
+    switch (type)
+    {
+    case ODID_MESSAGETYPE_BASIC_ID: {
+        const ODID_BasicID_encoded *basicId = (const ODID_BasicID_encoded *) msgData;
+        // Keep the first Basic ID; a later one only replaces it if of the same type
+        if ((leanData->Valid & ODID_LEAN_TYPE(type)) && leanData->IDType != ODID_IDTYPE_NONE &&
+            leanData->IDType != basicId->IDType)
+            return ODID_SUCCESS;
+        leanData->IDType = basicId->IDType;
+        leanData->UAType = basicId->UAType;
+        safe_dec_copyfill(leanData->UASID, basicId->UASID, sizeof(leanData->UASID));
+        break;
+    }
+    case ODID_MESSAGETYPE_LOCATION: {
+        const ODID_Location_encoded *location = (const ODID_Location_encoded *) msgData;
+        leanData->Status = location->Status;
+        leanData->Direction = location->Direction + (location->EWDirection ? 180 : 0);
+        if (location->SpeedMult)
+            leanData->SpeedHorizontal = location->SpeedHorizontal * 75 + UINT8_MAX * 25;
+        else
+            leanData->SpeedHorizontal = location->SpeedHorizontal * 25;
+        leanData->SpeedVertical = location->SpeedVertical * 50;
+        leanData->Latitude = location->Latitude;
+        leanData->Longitude = location->Longitude;
+        leanData->AltitudeGeo = decodeAltitudeLean(location->AltitudeGeo);
+        leanData->Height = decodeAltitudeLean(location->Height);
+        break;
+    }
+    case ODID_MESSAGETYPE_AUTH: {
+        const ODID_Auth_encoded *auth = (const ODID_Auth_encoded *) msgData;
+        int pageNum = auth->page_zero.DataPage;
+        if (pageNum >= ODID_AUTH_MAX_PAGES)
+            return ODID_FAIL;
+        if (pageNum == 0) {
+            if (auth->page_zero.LastPageIndex >= ODID_AUTH_MAX_PAGES)
+                return ODID_FAIL;
+#if (MAX_AUTH_LENGTH < UINT8_MAX)
+            if (auth->page_zero.Length > MAX_AUTH_LENGTH)
+                return ODID_FAIL;
+#endif
+            int len = ODID_AUTH_PAGE_ZERO_DATA_SIZE +
+                      auth->page_zero.LastPageIndex * ODID_AUTH_PAGE_NONZERO_DATA_SIZE;
+            if (len < auth->page_zero.Length)
+                return ODID_FAIL;
+            leanData->AuthLastPageIndex = auth->page_zero.LastPageIndex;
+            leanData->AuthLength = auth->page_zero.Length;
+            leanData->AuthTimestamp = auth->page_zero.Timestamp;
+        }
+        leanData->AuthType = auth->page_zero.AuthType;
+        leanData->AuthPages |= (uint16_t) (1u << pageNum);
+        leanData->AuthPageData[pageNum] = pageNum == 0 ? auth->page_zero.AuthData :
+                                                         auth->page_non_zero.AuthData;
+        break;
+    }
+    case ODID_MESSAGETYPE_SELF_ID: {
+        const ODID_SelfID_encoded *selfId = (const ODID_SelfID_encoded *) msgData;
+        leanData->DescType = selfId->DescType;
+        safe_dec_copyfill(leanData->Desc, selfId->Desc, sizeof(leanData->Desc));
+        break;
+    }
+    case ODID_MESSAGETYPE_SYSTEM: {
+        const ODID_System_encoded *system = (const ODID_System_encoded *) msgData;
+        leanData->OperatorLatitude = system->OperatorLatitude;
+        leanData->OperatorLongitude = system->OperatorLongitude;
+        break;
+    }
+    case ODID_MESSAGETYPE_OPERATOR_ID: {
+        const ODID_OperatorID_encoded *operatorId = (const ODID_OperatorID_encoded *) msgData;
+        leanData->OperatorIdType = operatorId->OperatorIdType;
+        safe_dec_copyfill(leanData->OperatorId, operatorId->OperatorId,
+                          sizeof(leanData->OperatorId));
+        break;
+    }
+    default:
+        return ODID_FAIL;
+    }
+    leanData->Valid |= ODID_LEAN_TYPE(type);
+    return ODID_SUCCESS;
+}
+
+/**
+* Decode a Message Pack in place into lean data
+*
+* The pack is read where it lies; messages whose type is not in wanted are
+* skipped without being decoded. No floating point is used. The caller must
+* call odid_initLeanData() first.
+*
+* @param leanData Output: lean data
+* @param pack     Pointer to an encoded packed message
+* @param buflen   Bytes available at pack
+* @param wanted   ODID_LEAN_TYPE() bits of the message types to decode
+* @return         Size of the pack in bytes, or -1 if it is not a valid pack
+*/
+int decodeMessagePackLean(ODID_Lean_data *leanData, const uint8_t *pack, size_t buflen,
+                          uint8_t wanted)
+{
+    if (!leanData || !pack || buflen < 3)
+        return -1;
+
+    const ODID_MessagePack_encoded *msgPack = (const ODID_MessagePack_encoded *) pack;
+    if (msgPack->MessageType != ODID_MESSAGETYPE_PACKED ||
+        msgPack->SingleMessageSize != ODID_MESSAGE_SIZE)
+        return -1;
+
+    size_t size = 3 + (size_t) msgPack->MsgPackSize * ODID_MESSAGE_SIZE;
+    if (size > buflen)
+        return -1;
+
+    if (checkPackContent((ODID_Message_encoded *) msgPack->Messages, msgPack->MsgPackSize) != ODID_SUCCESS)
+        return -1;
+
+    for (int i = 0; i < msgPack->MsgPackSize; i++) {
+        const uint8_t *msgData = msgPack->Messages[i].rawData;
+        ODID_messagetype_t type = decodeMessageType(msgData[0]);
+        if (wanted & ODID_LEAN_TYPE(type))
+            decodeMessageLean(leanData, msgData, type);
+    }
+    return (int) size;
+}
+
+/**
+* Lean counterpart of decodeOpenDroneID()
+*
+* Decodes a single message or a Message Pack into lean data. As with
+* decodeOpenDroneID(), msgData must hold a full message, or the full pack.
+*
+* @param leanData Output: lean data; call odid_initLeanData() first
+* @param msgData  Pointer to the encoded message
+* @param wanted   ODID_LEAN_TYPE() bits of the message types to decode
+* @return         The message type: ODID_messagetype_t
+*/
+ODID_messagetype_t decodeOpenDroneIDLean(ODID_Lean_data *leanData, const uint8_t *msgData,
+                                         uint8_t wanted)
+{
+    if (!leanData || !msgData)
+        return ODID_MESSAGETYPE_INVALID;
+
+    ODID_messagetype_t type = decodeMessageType(msgData[0]);
+    if (type == ODID_MESSAGETYPE_PACKED) {
+        size_t size = 3 + (size_t) msgData[2] * ODID_MESSAGE_SIZE;
+        if (decodeMessagePackLean(leanData, msgData, size, wanted) < 0)
+            return ODID_MESSAGETYPE_INVALID;
+        return type;
+    }
+    if (!(wanted & ODID_LEAN_TYPE(type)) ||
+        decodeMessageLean(leanData, msgData, type) != ODID_SUCCESS)
+        return ODID_MESSAGETYPE_INVALID;
+    return type;
+}
+
 /**
 * Safely fill then copy string to destination (when decoding)
 *
@@ -1060,6 +1249,70 @@ static int intInRange(int inValue, int startRange, int endRange)
     }
 }
 
+/*
+ * Accuracy enum codecs. Each enum value's bound sits in a table indexed by
+ * the value; the create functions scan the bounds from the largest down with
+ * the comparisons of the former if/else ladders, so results are unchanged
+ * (test/test_native_codec checks every input). Enums are 4 bits on the air,
+ * so every decode table has 16 entries and undefined values decode as
+ * unknown, as before.
+ */
+
+// Lower bound of each enum from ODID_HOR_ACC_10NM down to ODID_HOR_ACC_3_METER;
+// ODID_HOR_ACC_UNKNOWN at [0] is anything at or above 18520 m
+static const float horizAccuracyBounds[ODID_HOR_ACC_1_METER] = {
+    18520, 7408, 3704, 1852, 926, 555.6f, 185.2f, 92.6f, 30, 10, 3, 1,
+};
+
+static const float vertAccuracyBounds[ODID_VER_ACC_1_METER] = {
+    150, 45, 25, 10, 3, 1,
+};
+
+static const float speedAccuracyBounds[ODID_SPEED_ACC_0_3_METERS_PER_SECOND] = {
+    10, 3, 1, 0.3f,
+};
+
+// Exclusive lower bounds from ODID_TIME_ACC_UNKNOWN (above 1.5 s) down to
+// ODID_TIME_ACC_0_1_SECOND
+static const float timeAccuracyBounds[ODID_TIME_ACC_1_5_SECOND + 1] = {
+    1.5f, 1.4f, 1.3f, 1.2f, 1.1f, 1.0f, 0.9f, 0.8f, 0.7f, 0.6f, 0.5f, 0.4f, 0.3f, 0.2f, 0.1f, 0.0f,
+};
+
+static const float horizAccuracyValues[16] = {
+    18520, 18520, 7808, 3704, 1852, 926, 555.6f, 185.2f, 92.6f, 30, 10, 3, 1, 18520, 18520, 18520,
+};
+
+static const float vertAccuracyValues[16] = {
+    150, 150, 45, 25, 10, 3, 1, 150, 150, 150, 150, 150, 150, 150, 150, 150,
+};
+
+static const float speedAccuracyValues[16] = {
+    10, 10, 3, 1, 0.3f, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+};
+
+static const float timeAccuracyValues[16] = {
+    0.0f, 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f, 0.9f, 1.0f, 1.1f, 1.2f, 1.3f, 1.4f, 1.5f,
+};
+
+/**
+* Index of the first bound that Accuracy reaches
+*
+* Also the enum value for every ladder where bound n belongs to enum n and
+* anything above zero below the last bound to enum count. NaN reaches none.
+*
+* @param Accuracy The accuracy to look up
+* @param bounds   Lower bounds, largest first
+* @param count    Entries in bounds
+* @return         Enum value, or 0 (unknown) for zero, negative or NaN input
+*/
+static int accuracyEnum(float Accuracy, const float *bounds, int count)
+{
+    int i = 0;
+    while (i < count && !(Accuracy >= bounds[i]))
+        i++;
+    return (i < count || Accuracy > 0) ? i : 0;
+}
+
 /**
 * This converts a horizontal accuracy float value to the corresponding enum
 *
@@ -1068,34 +1321,8 @@ static int intInRange(int inValue, int startRange, int endRange)
 */
 ODID_Horizontal_accuracy_t createEnumHorizontalAccuracy(float Accuracy)
 {
-    if (Accuracy >= 18520)
-        return ODID_HOR_ACC_UNKNOWN;
-    else if (Accuracy >= 7408)
-        return ODID_HOR_ACC_10NM;
-    else if (Accuracy >= 3704)
-        return ODID_HOR_ACC_4NM;
-    else if (Accuracy >= 1852)
-        return ODID_HOR_ACC_2NM;
-    else if (Accuracy >= 926)
-        return ODID_HOR_ACC_1NM;
-    else if (Accuracy >= 555.6f)
-        return ODID_HOR_ACC_0_5NM;
-    else if (Accuracy >= 185.2f)
-        return ODID_HOR_ACC_0_3NM;
-    else if (Accuracy >= 92.6f)
-        return ODID_HOR_ACC_0_1NM;
-    else if (Accuracy >= 30)
-        return ODID_HOR_ACC_0_05NM;
-    else if (Accuracy >= 10)
-        return ODID_HOR_ACC_30_METER;
-    else if (Accuracy >= 3)
-        return ODID_HOR_ACC_10_METER;
-    else if (Accuracy >= 1)
-        return ODID_HOR_ACC_3_METER;
-    else if (Accuracy > 0)
-        return ODID_HOR_ACC_1_METER;
-    else
-        return ODID_HOR_ACC_UNKNOWN;
+    return (ODID_Horizontal_accuracy_t) accuracyEnum(Accuracy, horizAccuracyBounds,
+                                                     ODID_HOR_ACC_1_METER);
 }
 
 /**
@@ -1106,22 +1333,8 @@ ODID_Horizontal_accuracy_t createEnumHorizontalAccuracy(float Accuracy)
 */
 ODID_Vertical_accuracy_t createEnumVerticalAccuracy(float Accuracy)
 {
-    if (Accuracy >= 150)
-        return ODID_VER_ACC_UNKNOWN;
-    else if (Accuracy >= 45)
-        return ODID_VER_ACC_150_METER;
-    else if (Accuracy >= 25)
-        return ODID_VER_ACC_45_METER;
-    else if (Accuracy >= 10)
-        return ODID_VER_ACC_25_METER;
-    else if (Accuracy >= 3)
-        return ODID_VER_ACC_10_METER;
-    else if (Accuracy >= 1)
-        return ODID_VER_ACC_3_METER;
-    else if (Accuracy > 0)
-        return ODID_VER_ACC_1_METER;
-    else
-        return ODID_VER_ACC_UNKNOWN;
+    return (ODID_Vertical_accuracy_t) accuracyEnum(Accuracy, vertAccuracyBounds,
+                                                   ODID_VER_ACC_1_METER);
 }
 
 /**
@@ -1132,18 +1345,8 @@ ODID_Vertical_accuracy_t createEnumVerticalAccuracy(float Accuracy)
 */
 ODID_Speed_accuracy_t createEnumSpeedAccuracy(float Accuracy)
 {
-    if (Accuracy >= 10)
-        return ODID_SPEED_ACC_UNKNOWN;
-    else if (Accuracy >= 3)
-        return ODID_SPEED_ACC_10_METERS_PER_SECOND;
-    else if (Accuracy >= 1)
-        return ODID_SPEED_ACC_3_METERS_PER_SECOND;
-    else if (Accuracy >= 0.3f)
-        return ODID_SPEED_ACC_1_METERS_PER_SECOND;
-    else if (Accuracy > 0)
-        return ODID_SPEED_ACC_0_3_METERS_PER_SECOND;
-    else
-        return ODID_SPEED_ACC_UNKNOWN;
+    return (ODID_Speed_accuracy_t) accuracyEnum(Accuracy, speedAccuracyBounds,
+                                                ODID_SPEED_ACC_0_3_METERS_PER_SECOND);
 }
 
 /**
@@ -1154,40 +1357,13 @@ ODID_Speed_accuracy_t createEnumSpeedAccuracy(float Accuracy)
 */
 ODID_Timestamp_accuracy_t createEnumTimestampAccuracy(float Accuracy)
 {
-    if (Accuracy > 1.5f)
-        return ODID_TIME_ACC_UNKNOWN;
-    else if (Accuracy > 1.4f)
-        return ODID_TIME_ACC_1_5_SECOND;
-    else if (Accuracy > 1.3f)
-        return ODID_TIME_ACC_1_4_SECOND;
-    else if (Accuracy > 1.2f)
-        return ODID_TIME_ACC_1_3_SECOND;
-    else if (Accuracy > 1.1f)
-        return ODID_TIME_ACC_1_2_SECOND;
-    else if (Accuracy > 1.0f)
-        return ODID_TIME_ACC_1_1_SECOND;
-    else if (Accuracy > 0.9f)
-        return ODID_TIME_ACC_1_0_SECOND;
-    else if (Accuracy > 0.8f)
-        return ODID_TIME_ACC_0_9_SECOND;
-    else if (Accuracy > 0.7f)
-        return ODID_TIME_ACC_0_8_SECOND;
-    else if (Accuracy > 0.6f)
-        return ODID_TIME_ACC_0_7_SECOND;
-    else if (Accuracy > 0.5f)
-        return ODID_TIME_ACC_0_6_SECOND;
-    else if (Accuracy > 0.4f)
-        return ODID_TIME_ACC_0_5_SECOND;
-    else if (Accuracy > 0.3f)
-        return ODID_TIME_ACC_0_4_SECOND;
-    else if (Accuracy > 0.2f)
-        return ODID_TIME_ACC_0_3_SECOND;
-    else if (Accuracy > 0.1f)
-        return ODID_TIME_ACC_0_2_SECOND;
-    else if (Accuracy > 0.0f)
-        return ODID_TIME_ACC_0_1_SECOND;
-    else
+    // The enum counts up in 0.1 s steps while the bounds count down
+    int i = 0;
+    while (i <= ODID_TIME_ACC_1_5_SECOND && !(Accuracy > timeAccuracyBounds[i]))
+        i++;
+    if (i == 0 || i > ODID_TIME_ACC_1_5_SECOND)
         return ODID_TIME_ACC_UNKNOWN;
+    return (ODID_Timestamp_accuracy_t) (ODID_TIME_ACC_1_5_SECOND + 1 - i);
 }
 
 /**
@@ -1198,37 +1374,7 @@ ODID_Timestamp_accuracy_t createEnumTimestampAccuracy(float Accuracy)
 */
 float decodeHorizontalAccuracy(ODID_Horizontal_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_HOR_ACC_UNKNOWN:
-        return 18520;
-    case ODID_HOR_ACC_10NM:
-        return 18520;
-    case ODID_HOR_ACC_4NM:
-        return 7808;
-    case ODID_HOR_ACC_2NM:
-        return 3704;
-    case ODID_HOR_ACC_1NM:
-        return 1852;
-    case ODID_HOR_ACC_0_5NM:
-        return 926;
-    case ODID_HOR_ACC_0_3NM:
-        return 555.6f;
-    case ODID_HOR_ACC_0_1NM:
-        return 185.2f;
-    case ODID_HOR_ACC_0_05NM:
-        return 92.6f;
-    case ODID_HOR_ACC_30_METER:
-        return 30;
-    case ODID_HOR_ACC_10_METER:
-        return 10;
-    case ODID_HOR_ACC_3_METER:
-        return 3;
-    case ODID_HOR_ACC_1_METER:
-        return 1;
-    default:
-        return 18520;
-    }
+    return (unsigned) Accuracy < 16 ? horizAccuracyValues[Accuracy] : 18520;
 }
 
 /**
@@ -1239,25 +1385,7 @@ float decodeHorizontalAccuracy(ODID_Horizontal_accuracy_t Accuracy)
 */
 float decodeVerticalAccuracy(ODID_Vertical_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_VER_ACC_UNKNOWN:
-        return 150;
-    case ODID_VER_ACC_150_METER:
-        return 150;
-    case ODID_VER_ACC_45_METER:
-        return 45;
-    case ODID_VER_ACC_25_METER:
-        return 25;
-    case ODID_VER_ACC_10_METER:
-        return 10;
-    case ODID_VER_ACC_3_METER:
-        return 3;
-    case ODID_VER_ACC_1_METER:
-        return 1;
-    default:
-        return 150;
-    }
+    return (unsigned) Accuracy < 16 ? vertAccuracyValues[Accuracy] : 150;
 }
 
 /**
@@ -1268,21 +1396,7 @@ float decodeVerticalAccuracy(ODID_Vertical_accuracy_t Accuracy)
 */
 float decodeSpeedAccuracy(ODID_Speed_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_SPEED_ACC_UNKNOWN:
-        return 10;
-    case ODID_SPEED_ACC_10_METERS_PER_SECOND:
-        return 10;
-    case ODID_SPEED_ACC_3_METERS_PER_SECOND:
-        return 3;
-    case ODID_SPEED_ACC_1_METERS_PER_SECOND:
-        return 1;
-    case ODID_SPEED_ACC_0_3_METERS_PER_SECOND:
-        return 0.3f;
-    default:
-        return 10;
-    }
+    return (unsigned) Accuracy < 16 ? speedAccuracyValues[Accuracy] : 10;
 }
 
 /**
@@ -1293,43 +1407,7 @@ float decodeSpeedAccuracy(ODID_Speed_accuracy_t Accuracy)
 */
 float decodeTimestampAccuracy(ODID_Timestamp_accuracy_t Accuracy)
 {
-    switch (Accuracy)
-    {
-    case ODID_TIME_ACC_UNKNOWN:
-        return 0.0f;
-    case ODID_TIME_ACC_0_1_SECOND:
-        return 0.1f;
-    case ODID_TIME_ACC_0_2_SECOND:
-        return 0.2f;
-    case ODID_TIME_ACC_0_3_SECOND:
-        return 0.3f;
-    case ODID_TIME_ACC_0_4_SECOND:
-        return 0.4f;
-    case ODID_TIME_ACC_0_5_SECOND:
-        return 0.5f;
-    case ODID_TIME_ACC_0_6_SECOND:
-        return 0.6f;
-    case ODID_TIME_ACC_0_7_SECOND:
-        return 0.7f;
-    case ODID_TIME_ACC_0_8_SECOND:
-        return 0.8f;
-    case ODID_TIME_ACC_0_9_SECOND:
-        return 0.9f;
-    case ODID_TIME_ACC_1_0_SECOND:
-        return 1.0f;
-    case ODID_TIME_ACC_1_1_SECOND:
-        return 1.1f;
-    case ODID_TIME_ACC_1_2_SECOND:
-        return 1.2f;
-    case ODID_TIME_ACC_1_3_SECOND:
-        return 1.3f;
-    case ODID_TIME_ACC_1_4_SECOND:
-        return 1.4f;
-    case ODID_TIME_ACC_1_5_SECOND:
-        return 1.5f;
-    default:
-        return 0.0f;
-    }
+    return (unsigned) Accuracy < 16 ? timeAccuracyValues[Accuracy] : 0.0f;
 }
 
 #ifndef ODID_DISABLE_PRINTF
@@ -616,6 +616,58 @@ typedef struct ODID_MessagePack_data {
     ODID_Message_encoded Messages[ODID_PACK_MAX_MESSAGES];
 } ODID_MessagePack_data;
 
+/*
+ * Lean decoding output. Holds the fields a receiver typically tracks, in
+ * fixed point, for the message types asked for. Only the fields of types set
+ * in Valid are meaningful; see decodeMessagePackLean().
+ */
+#define ODID_LEAN_TYPE(type) ((uint8_t) (1u << (type)))
+#define ODID_LEAN_ALL        0x3F  // Basic ID through Operator ID
+
+typedef struct ODID_Lean_data {
+    uint8_t Valid;               // ODID_LEAN_TYPE() bit per message type decoded
+
+    // Basic ID. The first one in the pack, or a later one of the same IDType
+    uint8_t IDType;
+    uint8_t UAType;
+    char UASID[ODID_ID_SIZE + 1];
+
+    // Location
+    uint8_t Status;
+    int32_t Latitude;            // 1e-7 degrees, as encoded
+    int32_t Longitude;           // 1e-7 degrees, as encoded
+    int16_t AltitudeGeo;         // meter, truncated toward zero. Unknown: -1000m
+    int16_t Height;              // meter, truncated toward zero. Unknown: -1000m
+    uint16_t Direction;          // Degrees. Unknown: 361deg
+    uint16_t SpeedHorizontal;    // cm/s. Unknown: 25500cm/s
+    int16_t SpeedVertical;       // cm/s. Unknown: 6300cm/s
+
+    // Authentication. Bit n of AuthPages set for each page n present; the
+    // other fields come from page 0 and are only set when bit 0 is
+    uint16_t AuthPages;
+    uint8_t AuthType;
+    uint8_t AuthLastPageIndex;
+    uint8_t AuthLength;
+    uint32_t AuthTimestamp;
+    // AuthData of page n, pointing into the decoded buffer: only set for the
+    // pages in AuthPages and only valid while that buffer is. Page 0 carries
+    // ODID_AUTH_PAGE_ZERO_DATA_SIZE bytes, the others
+    // ODID_AUTH_PAGE_NONZERO_DATA_SIZE
+    const uint8_t *AuthPageData[ODID_AUTH_MAX_PAGES];
+
+    // Self ID
+    uint8_t DescType;
+    char Desc[ODID_STR_SIZE + 1];
+
+    // System
+    int32_t OperatorLatitude;    // 1e-7 degrees, as encoded
+    int32_t OperatorLongitude;   // 1e-7 degrees, as encoded
+
+    // Operator ID
+    uint8_t OperatorIdType;
+    char OperatorId[ODID_ID_SIZE + 1];
+} ODID_Lean_data;
+
 // API Calls
 void odid_initBasicIDData(ODID_BasicID_data *data);
 void odid_initLocationData(ODID_Location_data *data);
@@ -647,6 +699,12 @@ int getAuthPageNum(ODID_Auth_encoded *inEncoded, int *pageNum);
 ODID_messagetype_t decodeMessageType(uint8_t byte);
 ODID_messagetype_t decodeOpenDroneID(ODID_UAS_Data *uas_data, uint8_t *msg_data);
 
+void odid_initLeanData(ODID_Lean_data *data);
+int decodeMessagePackLean(ODID_Lean_data *leanData, const uint8_t *pack, size_t buflen,
+                          uint8_t wanted);
+ODID_messagetype_t decodeOpenDroneIDLean(ODID_Lean_data *leanData, const uint8_t *msgData,
+                                         uint8_t wanted);
+
 // Helper Functions
 ODID_Horizontal_accuracy_t createEnumHorizontalAccuracy(float Accuracy);
 ODID_Vertical_accuracy_t createEnumVerticalAccuracy(float Accuracy);
@@ -745,6 +803,22 @@ int odid_message_process_pack(ODID_UAS_Data *UAS_Data, uint8_t *pack, size_t buf
 int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
                                                     char *mac, uint8_t *buf, size_t buf_size);
 
+/* odid_wifi_receive_message_pack_nan_action_frame_lean - as above, but decodes
+ * the message pack in place into lean data (see decodeMessagePackLean())
+ * @lean_data: lean drone data, prepared with odid_initLeanData()
+ * @mac: receives the 6 byte source address of the NAN frame
+ * @buf: pointer to buffer space where the NAN is stored
+ * @buf_size: maximum size of the buffer
+ * @wanted: ODID_LEAN_TYPE() bits of the message types to decode
+ *
+ * Returns 0 on success, or < 0 on error: -EINVAL when the frame is not an
+ * ODID NAN service discovery frame, -ENOMEM when it is shorter than its
+ * headers claim and -EBADMSG when the message pack inside is invalid.
+ */
+int odid_wifi_receive_message_pack_nan_action_frame_lean(ODID_Lean_data *lean_data, char *mac,
+                                                         const uint8_t *buf, size_t buf_size,
+                                                         uint8_t wanted);
+
 #ifndef ODID_DISABLE_PRINTF
 void printByteArray(uint8_t *byteArray, uint16_t asize, int spaced);
 void printBasicID_data(ODID_BasicID_data *BasicID);
@@ -550,8 +550,12 @@ int odid_message_process_pack(ODID_UAS_Data *UAS_Data, uint8_t *pack, size_t buf
     return (int) size;
 }
 
-int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
-                                                    char *mac, uint8_t *buf, size_t buf_size)
+/* Checks every header of a NAN action frame carrying a message pack and
+ * returns the offset of the pack in buf, -EINVAL when a header does not
+ * match, or -ENOMEM when buf ends before the headers say it should. The pack
+ * itself is left alone apart from its length; *pack_size receives that length.
+ */
+static int nan_action_frame_find_pack(char *mac, uint8_t *buf, size_t buf_size, size_t *pack_size)
 {
     struct ieee80211_mgmt *mgmt;
     struct nan_service_discovery *nsd;
@@ -561,12 +565,12 @@ int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
     uint8_t target_addr[6] = { 0x51, 0x6F, 0x9A, 0x01, 0x00, 0x00 };
     uint8_t wifi_alliance_oui[3] = { 0x50, 0x6F, 0x9A };
     uint8_t service_id[6] = { 0x88, 0x69, 0x19, 0x9D, 0x92, 0x09 };
-    int ret;
     size_t len = 0;
+    size_t ret, pack;
 
     /* IEEE 802.11 Management Header */
     if (len + sizeof(*mgmt) > buf_size)
-        return -EINVAL;
+        return -ENOMEM;
     mgmt = (struct ieee80211_mgmt *)(buf + len);
     if ((mgmt->frame_control & cpu_to_le16(IEEE80211_FCTL_FTYPE | IEEE80211_FCTL_STYPE)) !=
         cpu_to_le16(IEEE80211_FTYPE_MGMT | IEEE80211_STYPE_ACTION))
@@ -579,7 +583,7 @@ int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
 
     /* NAN Service Discovery header */
     if (len + sizeof(*nsd) > buf_size)
-        return -EINVAL;
+        return -ENOMEM;
     nsd = (struct nan_service_discovery *)(buf + len);
     if (nsd->category != 0x04)
         return -EINVAL;
@@ -593,7 +597,7 @@ int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
 
     /* NAN Attribute for Service Descriptor header */
     if (len + sizeof(*nsda) > buf_size)
-        return -EINVAL;
+        return -ENOMEM;
     nsda = (struct nan_service_descriptor_attribute *)(buf + len);
     if (nsda->header.attribute_id != 0x3)
         return -EINVAL;
@@ -606,9 +610,14 @@ int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
     len += sizeof(*nsda);
 
     si = (struct ODID_service_info *)(buf + len);
-    ret = odid_message_process_pack(UAS_Data, buf + len + sizeof(*si), buf_size - len - sizeof(*nsdea));
-    if (ret < 0)
+    pack = len + sizeof(*si);
+    if (pack + 3 > buf_size)
+        return -ENOMEM;
+    if (buf[pack + 2] > ODID_PACK_MAX_MESSAGES)
         return -EINVAL;
+    ret = 3 + (size_t) buf[pack + 2] * ODID_MESSAGE_SIZE;
+    if (ret > buf_size - len - sizeof(*nsdea))
+        return -ENOMEM;
     if (nsda->service_info_length != (sizeof(*si) + ret))
         return -EINVAL;
     if (nsda->header.length != (cpu_to_le16(sizeof(*nsda) - sizeof(struct nan_attribute_header) + nsda->service_info_length)))
@@ -628,5 +637,31 @@ int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
     if (nsdea->control != cpu_to_le16(0x0200))
         return -EINVAL;
 
+    *pack_size = ret;
+    return (int) pack;
+}
+
+int odid_wifi_receive_message_pack_nan_action_frame(ODID_UAS_Data *UAS_Data,
+                                                    char *mac, uint8_t *buf, size_t buf_size)
+{
+    size_t pack_size;
+    int pack = nan_action_frame_find_pack(mac, buf, buf_size, &pack_size);
+    if (pack < 0)
+        return pack;
+    if (odid_message_process_pack(UAS_Data, buf + pack, pack_size) < 0)
+        return -EINVAL;
+    return 0;
+}
+
+int odid_wifi_receive_message_pack_nan_action_frame_lean(ODID_Lean_data *lean_data, char *mac,
+                                                         const uint8_t *buf, size_t buf_size,
+                                                         uint8_t wanted)
+{
+    size_t pack_size;
+    int pack = nan_action_frame_find_pack(mac, (uint8_t *) buf, buf_size, &pack_size);
+    if (pack < 0)
+        return pack;
+    if (decodeMessagePackLean(lean_data, buf + pack, pack_size, wanted) < 0)
+        return -EBADMSG;
     return 0;
 }
@@ -0,0 +1,228 @@
+#include "ble_scan.h"
+
+volatile uint32_t bleSeen = 0;
+volatile uint32_t blePassed = 0;
+volatile uint32_t bleDuplicates = 0;
+
+#if RID_ENABLE_BLE
+
+#include <Arduino.h>
+#include <string.h>
+#include <BLEDevice.h>
+#include <esp_gap_ble_api.h>
+#include <esp_timer.h>
+#include "coex_scheduler.h"
+#include "metrics.h"
+#include "opendroneid.h"
+#include "rid_prefilter.h"
+#include "task_stats.h"
+#include "track.h"
+
+#ifndef RID_BLE_SCAN_INTERVAL
+#define RID_BLE_SCAN_INTERVAL 50        // ms, per PHY on the extended scan
+#endif
+#ifndef RID_BLE_SCAN_WINDOW
+#define RID_BLE_SCAN_WINDOW   50
+#endif
+
+#define BLE_SCAN_UNITS(ms) ((ms) * 8 / 5)  // 0.625 ms controller units
+
+#define BLE_DUP_SLOTS 64                // Power of two
+
+// The C3/S3 and the C6 controllers name the duplicate filter type differently.
+#if (defined(CONFIG_BT_CTRL_SCAN_DUPL_TYPE) && CONFIG_BT_CTRL_SCAN_DUPL_TYPE == 2) || \
+    (defined(CONFIG_BT_LE_SCAN_DUPL_TYPE) && CONFIG_BT_LE_SCAN_DUPL_TYPE == 2)
+#define BLE_SCAN_DUPLICATE BLE_SCAN_DUPLICATE_ENABLE
+#else
+#define BLE_SCAN_DUPLICATE BLE_SCAN_DUPLICATE_DISABLE
+#endif
+
+// Last accepted counter per address and message type. A collision just
+// evicts the older key, which at worst lets one repeat through.
+struct ble_dup_slot {
+  uint8_t mac[6];
+  uint8_t type;
+  uint8_t counter;
+  uint32_t accepted_ms;
+};
+
+static ble_dup_slot dupSlots[BLE_DUP_SLOTS];  // Only the BLE host task touches this
+
+static bool ble_is_repeat(const uint8_t *mac, uint8_t type, uint8_t counter, uint32_t now) {
+  uint32_t h = type;
+  for (int i = 0; i < 6; i++) h = h * 31 + mac[i];
+  ble_dup_slot &s = dupSlots[h & (BLE_DUP_SLOTS - 1)];
+  if (s.accepted_ms && s.type == type && memcmp(s.mac, mac, 6) == 0 &&
+      s.counter == counter && now - s.accepted_ms < RID_BLE_DUP_REFRESH_MS) {
+    return true;
+  }
+  memcpy(s.mac, mac, 6);
+  s.type = type;
+  s.counter = counter;
+  s.accepted_ms = now ? now : 1;
+  return false;
+}
+
+static void start_scan();  // Sets the parameters; their completion event starts the scan
+
+// Shared by the legacy and extended scan reports; both arrive on the BLE
+// host task.
+static void handle_advert(rid_source source, const uint8_t *mac, int rssi, const uint8_t *adv, int len) {
+  TaskBusy busy(RID_TASK_BLE);
+  uint32_t captured_us = (uint32_t)esp_timer_get_time();
+  bleSeen++;
+  int odid_len;
+  const uint8_t *counter = find_odid_service_data(adv, len, &odid_len);
+  if (!counter) return;
+  const uint8_t *odid = counter + 1;
+
+  // Any message type, including a message pack as long as the advert
+  // really holds every message the pack header claims.
+  uint8_t type = decodeMessageType(odid[0]);
+  if (type == ODID_MESSAGETYPE_PACKED) {
+    if (odid_len < 3 || odid_len < 3 + odid[2] * ODID_MESSAGE_SIZE) {
+      metrics_note_failure(source, RID_FAIL_TRUNCATED);
+      return;
+    }
+  } else if (odid_len < ODID_MESSAGE_SIZE) {
+    metrics_note_failure(source, RID_FAIL_TRUNCATED);
+    return;
+  }
+  blePassed++;
+
+  if (ble_is_repeat(mac, type, *counter, millis())) {
+    bleDuplicates++;
+    return;
+  }
+
+  static ODID_Lean_data bleLean;
+  odid_initLeanData(&bleLean);
+  if (decodeOpenDroneIDLean(&bleLean, odid, RID_DECODE_TYPES) == ODID_MESSAGETYPE_INVALID) {
+    metrics_note_failure(source, RID_FAIL_MALFORMED);
+    return;
+  }
+  metrics_note_frame(source);
+  track_uas(mac, rssi, &bleLean, captured_us, captured_us);  // Bluedroid has no earlier RX time
+}
+
+#if RID_BLE_EXTENDED_SCAN
+
+// Interval and window are the same on both PHYs; the controller alternates
+// between them.
+static esp_ble_ext_scan_params_t extScanParams = {
+  .own_addr_type = BLE_ADDR_TYPE_PUBLIC,
+  .filter_policy = BLE_SCAN_FILTER_ALLOW_ALL,
+  .scan_duplicate = BLE_SCAN_DUPLICATE,
+  .cfg_mask = ESP_BLE_GAP_EXT_SCAN_CFG_UNCODE_MASK | ESP_BLE_GAP_EXT_SCAN_CFG_CODE_MASK,
+  .uncoded_cfg = {BLE_SCAN_TYPE_PASSIVE, BLE_SCAN_UNITS(RID_BLE_SCAN_INTERVAL), BLE_SCAN_UNITS(RID_BLE_SCAN_WINDOW)},
+  .coded_cfg = {BLE_SCAN_TYPE_PASSIVE, BLE_SCAN_UNITS(RID_BLE_SCAN_INTERVAL), BLE_SCAN_UNITS(RID_BLE_SCAN_WINDOW)},
+};
+
+static void gap_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+  switch (event) {
+  case ESP_GAP_BLE_EXT_SCAN_SET_PARAMS_COMPLETE_EVT:
+    esp_ble_gap_start_ext_scan(0, 0);  // No duration, no period: scan until reboot
+    break;
+  case ESP_GAP_BLE_EXT_SCAN_STOP_COMPLETE_EVT:
+    start_scan();  // Stopped for new timing
+    break;
+  case ESP_GAP_BLE_EXT_ADV_REPORT_EVT: {
+    const esp_ble_gap_ext_adv_report_t &r = param->ext_adv_report.params;
+    // Packs fit in one extended advert; fragments of longer chains are skipped.
+    if (r.data_status != ESP_BLE_GAP_EXT_ADV_DATA_COMPLETE) return;
+    rid_source source = (r.event_type & ESP_BLE_GAP_SET_EXT_ADV_PROP_LEGACY) ?
+                        RID_SOURCE_BLE_LEGACY : RID_SOURCE_BLE_EXTENDED;
+    handle_advert(source, r.addr, r.rssi, r.adv_data, r.adv_data_len);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+static void start_scan() {
+  esp_ble_gap_set_ext_scan_params(&extScanParams);
+}
+
+static void set_timing(uint16_t interval, uint16_t window) {
+  extScanParams.uncoded_cfg.scan_interval = extScanParams.coded_cfg.scan_interval = interval;
+  extScanParams.uncoded_cfg.scan_window = extScanParams.coded_cfg.scan_window = window;
+}
+
+static void stop_scan() {
+  esp_ble_gap_stop_ext_scan();
+}
+
+#else
+
+static esp_ble_scan_params_t scanParams = {
+  .scan_type = BLE_SCAN_TYPE_PASSIVE,
+  .own_addr_type = BLE_ADDR_TYPE_PUBLIC,
+  .scan_filter_policy = BLE_SCAN_FILTER_ALLOW_ALL,
+  .scan_interval = BLE_SCAN_UNITS(RID_BLE_SCAN_INTERVAL),
+  .scan_window = BLE_SCAN_UNITS(RID_BLE_SCAN_WINDOW),
+  .scan_duplicate = BLE_SCAN_DUPLICATE,
+};
+
+static void gap_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+  switch (event) {
+  case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT:
+    esp_ble_gap_start_scanning(0);  // Duration 0 runs until stopped
+    break;
+  case ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT:
+    start_scan();  // Stopped for new timing
+    break;
+  case ESP_GAP_BLE_SCAN_RESULT_EVT:
+    if (param->scan_rst.search_evt != ESP_GAP_SEARCH_INQ_RES_EVT) return;
+    handle_advert(RID_SOURCE_BLE_LEGACY, param->scan_rst.bda, param->scan_rst.rssi, param->scan_rst.ble_adv,
+                  param->scan_rst.adv_data_len);
+    break;
+  default:
+    break;
+  }
+}
+
+static void start_scan() {
+  esp_ble_gap_set_scan_params(&scanParams);
+}
+
+static void set_timing(uint16_t interval, uint16_t window) {
+  scanParams.scan_interval = interval;
+  scanParams.scan_window = window;
+}
+
+static void stop_scan() {
+  esp_ble_gap_stop_scanning();
+}
+
+#endif // RID_BLE_EXTENDED_SCAN
+
+// Window as ble_percent of the interval, at least the controller's 2.5 ms
+// minimum. The controller reads the parameters on the BLE host task, only
+// after a stop or at begin, so plain writes are safe.
+static void set_duty(uint8_t ble_percent) {
+  uint16_t interval = BLE_SCAN_UNITS(RID_COEX_BLE_INTERVAL_MS);
+  uint16_t window = (uint16_t)((uint32_t)interval * ble_percent / 100);
+  set_timing(interval, window < 4 ? 4 : window);
+}
+
+void ble_scan_set_duty(uint8_t ble_percent) {
+  set_duty(ble_percent);
+  stop_scan();  // The stop event starts it again with the new window
+}
+
+void ble_scan_begin(uint8_t ble_percent) {
+  if (ble_percent) set_duty(ble_percent);
+  // BLEDevice brings up the controller and Bluedroid and owns the one GAP
+  // callback; BLEScan is never created, so its handler stays out of the way.
+  BLEDevice::init("DroneID");
+  BLEDevice::setCustomGapHandler(gap_handler);
+#ifdef CONFIG_BT_BLUEDROID_PINNED_TO_CORE
+  task_stats_adopt(RID_TASK_BLE, "BTC_TASK", CONFIG_BT_BLUEDROID_PINNED_TO_CORE);
+#else
+  task_stats_adopt(RID_TASK_BLE, "BTC_TASK", -1);
+#endif
+  start_scan();
+}
+
+#endif // RID_ENABLE_BLE
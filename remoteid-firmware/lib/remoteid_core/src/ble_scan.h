@@ -0,0 +1,64 @@
+/*
+ * Bluetooth Remote ID capture (ASTM F3411 service data, UUID 0xFFFA). Built
+ * only with RID_ENABLE_BLE. The scan is started on the ESP-IDF GAP API and
+ * its reports arrive through BLEDevice's custom GAP handler, so adverts are
+ * checked on the raw bytes and nothing is constructed for the phones and
+ * beacons around us. Remote ID adverts are decoded and handed to
+ * track_uas().
+ *
+ * The scan is passive and runs continuously. On chips with BLE 5 (C3, S3,
+ * C6) it is an extended scan on the 1M and Coded PHYs, which also receives
+ * legacy adverts; -DRID_BLE_EXTENDED_SCAN=0 keeps the legacy scan.
+ *
+ * Repeats are dropped on the ODID message counter: an advert whose address,
+ * message type and counter match the last one accepted is skipped unless
+ * RID_BLE_DUP_REFRESH_MS has passed, which keeps broadcasters that never
+ * bump the counter alive in the tracker. When the controller's duplicate
+ * filter is keyed on address and data (SCAN_DUPL_TYPE_DATA_DEVICE in a
+ * custom sdkconfig) it is enabled too, and the counter byte makes every new
+ * message pass it.
+ *
+ * RID_BLE_SCAN_INTERVAL / RID_BLE_SCAN_WINDOW (ms), when set, override the
+ * scan timing; the extended scan uses them for each PHY. They only apply
+ * with RID_COEX_MODE off; otherwise coex.h sets the timing as a duty cycle.
+ */
+
+#ifndef BLE_SCAN_H
+#define BLE_SCAN_H
+
+#include <stdint.h>
+#include "rid_config.h"
+
+// Adverts the GAP handler saw, Remote ID adverts among them, and those
+// skipped as repeats of the last accepted counter.
+extern volatile uint32_t bleSeen;
+extern volatile uint32_t blePassed;
+extern volatile uint32_t bleDuplicates;
+
+#if RID_ENABLE_BLE
+
+#include <soc/soc_caps.h>
+
+#ifndef RID_BLE_EXTENDED_SCAN
+#if defined(SOC_BLE_50_SUPPORTED) && defined(CONFIG_BT_BLE_50_FEATURES_SUPPORTED)
+#define RID_BLE_EXTENDED_SCAN 1
+#else
+#define RID_BLE_EXTENDED_SCAN 0
+#endif
+#endif
+
+#ifndef RID_BLE_DUP_REFRESH_MS
+#define RID_BLE_DUP_REFRESH_MS 1000
+#endif
+
+// Initialises the BLE stack and starts the continuous scan, listening
+// ble_percent of every RID_COEX_BLE_INTERVAL_MS, or on the RID_BLE_SCAN_*
+// timing for 0.
+void ble_scan_begin(uint8_t ble_percent);
+
+// Restarts the scan with a new duty cycle. Not before ble_scan_begin().
+void ble_scan_set_duty(uint8_t ble_percent);
+
+#endif // RID_ENABLE_BLE
+
+#endif // BLE_SCAN_H
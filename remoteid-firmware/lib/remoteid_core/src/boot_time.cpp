@@ -0,0 +1,13 @@
+#include <esp_timer.h>
+#include "boot_time.h"
+
+static volatile uint32_t reached[BOOT_STAGE_COUNT];
+
+void boot_time_mark(boot_stage stage) {
+  // Racing first marks (decode and BLE tasks) both store a valid time
+  if (!reached[stage]) reached[stage] = (uint32_t)esp_timer_get_time() | 1;
+}
+
+uint32_t boot_time_us(boot_stage stage) {
+  return reached[stage];
+}
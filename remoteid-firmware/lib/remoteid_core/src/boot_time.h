@@ -0,0 +1,34 @@
+/*
+ * Boot milestones, for the blind window after a power cycle. Each stage
+ * keeps the esp_timer time it was first reached, which counts from the start
+ * of the application (the second-stage bootloader before it, typically
+ * 100-300 ms, is not included). The heartbeat reports them as boot_*_us.
+ *
+ *   capture    promiscuous capture on, the first moment a frame can land
+ *   ble        BLE scanning, brought up on its own task meanwhile
+ *   setup      setup() done: USB output, ESP-NOW and the flash log ready
+ *   first_rid  first Remote ID frame decoded from any source
+ *
+ * Marks are single writes of a stage's slot and may come from any task.
+ */
+
+#ifndef BOOT_TIME_H
+#define BOOT_TIME_H
+
+#include <stdint.h>
+
+enum boot_stage : uint8_t {
+  BOOT_CAPTURE,
+  BOOT_BLE,
+  BOOT_SETUP,
+  BOOT_FIRST_RID,
+  BOOT_STAGE_COUNT
+};
+
+// Records now for stage unless it was reached already.
+void boot_time_mark(boot_stage stage);
+
+// Microseconds from application start to stage, 0 if not reached yet.
+uint32_t boot_time_us(boot_stage stage);
+
+#endif // BOOT_TIME_H
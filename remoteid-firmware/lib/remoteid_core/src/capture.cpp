@@ -0,0 +1,208 @@
+#include <Arduino.h>
+#include <errno.h>
+#include <esp_event.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "opendroneid.h"
+#include "odid_wifi.h"
+#include "boot_time.h"
+#include "capture.h"
+#include "espnow_link.h"
+#include "metrics.h"
+#include "rid_config.h"
+#include "rid_prefilter.h"
+#include "task_stats.h"
+#include "track.h"
+
+FrameRing frameRing;
+ChannelScheduler channelScheduler;
+volatile uint32_t captureSeen = 0;
+volatile uint32_t capturePassed = 0;
+volatile uint32_t captureDecoded = 0;
+
+static TaskHandle_t decodeTaskHandle = nullptr;
+static ODID_Lean_data leanData;  // Only the decode task touches this
+
+// rx_ctrl.timestamp counts microseconds on the Wi-Fi MAC's own clock. Its
+// offset to esp_timer is the smallest gap seen between a frame's two stamps,
+// since the callback runs shortly after reception; the minimum is taken over
+// this window and the last so a restarted MAC clock is followed.
+#define RX_CLOCK_WINDOW_US 10000000UL
+static uint32_t rxGap = 0;
+static uint32_t rxGapLast = 0;
+static uint32_t rxWindowStart = 0;
+static bool rxClockSet = false;
+
+// When frame was received, on the esp_timer clock.
+static uint32_t rx_local_us(const raw_frame *frame) {
+  uint32_t gap = frame->captured_us - frame->rx_timestamp;
+  if (!rxClockSet || frame->captured_us - rxWindowStart > RX_CLOCK_WINDOW_US) {
+    rxGapLast = rxClockSet ? rxGap : gap;
+    rxGap = gap;
+    rxWindowStart = frame->captured_us;
+    rxClockSet = true;
+  } else if ((int32_t)(gap - rxGap) < 0) {
+    rxGap = gap;
+  }
+  uint32_t best = (int32_t)(rxGap - rxGapLast) < 0 ? rxGap : rxGapLast;
+  return frame->rx_timestamp + best;
+}
+
+// Feeds every detection of a node's batch to the tracker as if heard here.
+static void decode_espnow(const raw_frame *frame) {
+  EspNowBatchReader batch(frame->data, frame->len);
+  uint8_t mac[6];
+  int8_t rssi;
+  while (batch.next(mac, &rssi, &leanData)) {
+    metrics_note_frame(RID_SOURCE_ESPNOW);
+    track_uas(mac, rssi, &leanData, frame->captured_us, frame->captured_us);
+  }
+  if (!batch.done()) metrics_note_failure(RID_SOURCE_ESPNOW, RID_FAIL_MALFORMED);
+}
+
+// Decodes the message pack where it lies in the ring slot.
+static void decode_frame(const raw_frame *frame) {
+  if (frame->kind == FRAME_ESPNOW) {
+    decode_espnow(frame);
+    return;
+  }
+  odid_initLeanData(&leanData);
+  rid_source source = frame->kind == FRAME_NAN_ACTION ? RID_SOURCE_NAN : RID_SOURCE_BEACON;
+  if (frame->kind == FRAME_NAN_ACTION) {
+    char sender[6];
+    int ret = odid_wifi_receive_message_pack_nan_action_frame_lean(&leanData, sender, frame->data,
+                                                                   frame->len, RID_DECODE_TYPES);
+    if (ret != 0) {
+      metrics_note_failure(source, ret == -EINVAL ? RID_FAIL_NOT_RID :
+                                   ret == -ENOMEM ? RID_FAIL_TRUNCATED : RID_FAIL_MALFORMED);
+      return;
+    }
+  } else if (decodeMessagePackLean(&leanData, frame->data, frame->len, RID_DECODE_TYPES) < 0) {
+    metrics_note_failure(source, RID_FAIL_MALFORMED);
+    return;
+  }
+  captureDecoded++;
+  metrics_note_frame(source);
+  track_uas(frame->mac, frame->rssi, &leanData, frame->captured_us, rx_local_us(frame));
+}
+
+// Drains frameRing in batches: sleeps until the callback signals, then
+// decodes everything queued before sleeping again.
+static void decodeTask(void *parameter) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    TaskBusy busy(RID_TASK_DECODE);
+    const raw_frame *frame;
+    while ((frame = frameRing.peek()) != nullptr) {
+      decode_frame(frame);
+      frameRing.release();
+    }
+  }
+}
+
+// Moves the radio between channels as channelScheduler decides.
+static void channelHopTask(void *parameter) {
+  uint8_t current = CHANNEL_HOME;
+  for (;;) {
+    uint8_t ch;
+    {
+      TaskBusy busy(RID_TASK_HOP);
+      ch = channelScheduler.next(millis());
+      if (ch != current) {
+        espnow_channel_leave(current);
+        esp_wifi_set_channel(ch, WIFI_SECOND_CHAN_NONE);
+        current = ch;
+        espnow_channel_enter(ch);
+      }
+    }
+    vTaskDelay(pdMS_TO_TICKS(channelScheduler.dwell_ms(ch)));
+  }
+}
+
+// The promiscuous filter only lets management frames through; the first byte
+// then rejects every subtype but beacon and action before anything else.
+static void callback(void *buffer, wifi_promiscuous_pkt_type_t type) {
+  if (type != WIFI_PKT_MGMT) return;
+  captureSeen++;
+  
+  wifi_promiscuous_pkt_t *packet = (wifi_promiscuous_pkt_t *)buffer;
+  uint8_t *payload = packet->payload;
+  int length = packet->rx_ctrl.sig_len;
+  if (length < 24 + 4) return;
+  if (payload[0] != FC_BEACON && payload[0] != FC_ACTION) return;
+  capturePassed++;
+  
+  int data_len = 0;
+  uint8_t kind;
+  const uint8_t *data = rid_wifi_candidate(payload, length, &data_len, &kind);
+  if (!data) return;
+  channelScheduler.note_frame(packet->rx_ctrl.channel);
+  if (data_len > FRAME_RING_MAX_LEN) {
+    frameRing.drop_oversize();
+    return;
+  }
+  
+  raw_frame *frame = frameRing.reserve();
+  if (!frame) return;
+  frame->kind = kind;
+  frame->rssi = packet->rx_ctrl.rssi;
+  frame->channel = packet->rx_ctrl.channel;
+  frame->rx_timestamp = packet->rx_ctrl.timestamp;
+  frame->captured_us = (uint32_t)esp_timer_get_time();
+  frame->len = data_len;
+  memcpy(frame->mac, &payload[10], 6);
+  memcpy(frame->data, data, data_len);
+  frameRing.commit();
+  if (decodeTaskHandle) xTaskNotifyGive(decodeTaskHandle);
+}
+
+void capture_espnow(const uint8_t *node, int rssi, const uint8_t *data, int len) {
+  if (len > FRAME_RING_MAX_LEN) {
+    frameRing.drop_oversize();
+    return;
+  }
+  raw_frame *frame = frameRing.reserve();
+  if (!frame) return;
+  frame->kind = FRAME_ESPNOW;
+  frame->rssi = rssi;
+  frame->channel = RID_ESPNOW_CHANNEL;
+  frame->rx_timestamp = 0;
+  frame->captured_us = (uint32_t)esp_timer_get_time();
+  frame->len = len;
+  memcpy(frame->mac, node, 6);
+  memcpy(frame->data, data, len);
+  frameRing.commit();
+  if (decodeTaskHandle) xTaskNotifyGive(decodeTaskHandle);
+}
+
+// Starts the Wi-Fi driver in station mode straight through the IDF, without
+// the Arduino WiFi class: promiscuous capture and ESP-NOW need no network
+// interface, DHCP client or station config, so none is created or loaded.
+static void radio_begin() {
+  esp_event_loop_create_default();  // Already there is fine; the driver posts its events to it
+  wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+  cfg.nvs_enable = 0;  // No station config to read or write back; PHY calibration still uses NVS
+  esp_wifi_init(&cfg);
+  esp_wifi_set_storage(WIFI_STORAGE_RAM);
+  esp_wifi_set_mode(WIFI_MODE_STA);
+  esp_wifi_start();
+}
+
+void capture_begin() {
+  task_stats_create(RID_TASK_DECODE, decodeTask, "DecodeTask", RID_DECODE_STACK, RID_DECODE_PRIO,
+                    RID_DECODE_CORE, &decodeTaskHandle);
+  radio_begin();
+  wifi_promiscuous_filter_t filter = {};
+  filter.filter_mask = WIFI_PROMIS_FILTER_MASK_MGMT;
+  esp_wifi_set_promiscuous_filter(&filter);
+  esp_wifi_set_promiscuous(true);
+  esp_wifi_set_promiscuous_rx_cb(&callback);
+  esp_wifi_set_channel(CHANNEL_HOME, WIFI_SECOND_CHAN_NONE);
+  boot_time_mark(BOOT_CAPTURE);
+  if (CHANNEL_HOP_ENABLE) {
+    task_stats_create(RID_TASK_HOP, channelHopTask, "ChannelHopTask", RID_HOP_STACK, RID_HOP_PRIO,
+                      RID_WIFI_CORE, NULL);
+  }
+}
@@ -0,0 +1,41 @@
+/*
+ * Wi-Fi Remote ID capture. The promiscuous callback runs in the Wi-Fi driver
+ * task, so it only applies the cheap NAN destination / vendor OUI prefilter
+ * and copies candidates into frameRing. A decode task drains the ring and
+ * feeds track_uas(); a hop task moves the radio as channelScheduler decides.
+ * On a collector, batches from other nodes share the ring (capture_espnow()).
+ *
+ * Nothing on this path allocates: ring slots, the decode scratch record and
+ * the tracker table are all static, so the heap stays flat however busy the
+ * air is. The heartbeat's heap_* fields confirm it.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include "channel_scheduler.h"
+#include "frame_ring.h"
+
+extern FrameRing frameRing;
+extern ChannelScheduler channelScheduler;
+
+// Management frames the callback saw, those left after the beacon/action
+// subtype check, and frames the decode task turned into Remote ID messages.
+// Remote ID candidates are frameRing's pushed and drop counters.
+extern volatile uint32_t captureSeen;
+extern volatile uint32_t capturePassed;
+extern volatile uint32_t captureDecoded;
+
+// Queues a batch a node sent over ESP-NOW (espnow_link.h) for the decode
+// task. Call from the ESP-NOW receive callback only: it runs in the Wi-Fi
+// task like the promiscuous callback, so the ring keeps a single producer.
+void capture_espnow(const uint8_t *node, int rssi, const uint8_t *data, int len);
+
+// Starts Wi-Fi in station mode, puts the radio in promiscuous mode on
+// CHANNEL_HOME and starts the decode and hop tasks. Call first in setup(),
+// after nvs_flash_init(); frames are queued from then on, and tracked drones
+// wait for output_begin() to be printed.
+void capture_begin();
+
+#endif // CAPTURE_H
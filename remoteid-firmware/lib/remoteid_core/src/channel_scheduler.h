@@ -0,0 +1,167 @@
+/*
+ * Adaptive Wi-Fi channel scheduler for promiscuous Remote ID capture.
+ *
+ * The radio can only listen on one channel at a time. NAN Remote ID lives on
+ * channel 6 (and 149 on 5 GHz parts), but beacon Remote ID may sit on any
+ * channel, so the hop task stays mostly on the home channel and visits the
+ * others in between. Every channel's share grows with the Remote ID frames
+ * recently heard on it, so a drone beaconing on channel 11 quickly earns
+ * channel 11 more visits and loses them again once it goes quiet.
+ *
+ * Visits are ordered by stride scheduling: each channel advances a pass value
+ * by STRIDE / weight per visit and the lowest pass goes next, giving every
+ * channel visits in proportion to its weight without starving any of them.
+ *
+ * note_frame() runs in the Wi-Fi driver callback and next() in the hop task.
+ * Each counter has a single writer, so no lock is needed.
+ */
+
+#ifndef CHANNEL_SCHEDULER_H
+#define CHANNEL_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#if defined(__has_include)
+#if __has_include(<soc/soc_caps.h>)
+#include <soc/soc_caps.h>            // SOC_WIFI_SUPPORT_5G
+#endif
+#endif
+
+#ifndef CHANNEL_HOP_ENABLE
+#define CHANNEL_HOP_ENABLE 1             // 0 keeps the radio on CHANNEL_HOME
+#endif
+
+#ifndef CHANNEL_HOME
+#define CHANNEL_HOME 6                   // NAN Remote ID and most beacon RID
+#endif
+
+#ifndef CHANNEL_HOME_DWELL_MS
+#define CHANNEL_HOME_DWELL_MS 400        // Spans a NAN discovery window (512 TU period)
+#endif
+
+#ifndef CHANNEL_SCAN_DWELL_MS
+#define CHANNEL_SCAN_DWELL_MS 110        // Just over one 102.4 ms beacon interval
+#endif
+
+#ifndef CHANNEL_HOME_WEIGHT
+#define CHANNEL_HOME_WEIGHT 8            // Home visits per idle-channel visit
+#endif
+
+#ifndef CHANNEL_WEIGHT_CAP
+#define CHANNEL_WEIGHT_CAP 32            // Most weight activity can add
+#endif
+
+#ifndef CHANNEL_DECAY_MS
+#define CHANNEL_DECAY_MS 30000UL         // Activity score halves this often
+#endif
+
+// Channels visited, home first. 5 GHz only where the radio supports it.
+#ifndef CHANNEL_HOP_LIST
+#if defined(SOC_WIFI_SUPPORT_5G)
+#define CHANNEL_HOP_LIST 6, 1, 2, 3, 4, 5, 7, 8, 9, 10, 11, 149
+#else
+#define CHANNEL_HOP_LIST 6, 1, 2, 3, 4, 5, 7, 8, 9, 10, 11
+#endif
+#endif
+
+class ChannelScheduler {
+public:
+  static const uint8_t MAX_CHANNELS = 16;
+
+  ChannelScheduler() {
+    static const uint8_t list[] = { CHANNEL_HOP_LIST };
+    count_ = 0;
+    for (uint8_t i = 0; i < sizeof(list) && count_ < MAX_CHANNELS; i++) {
+      channel_[count_] = list[i];
+      frames_[count_] = 0;
+      counted_[count_] = 0;
+      score_[count_] = 0;
+      visits_[count_] = 0;
+      pass_[count_] = 0;
+      count_++;
+    }
+    last_decay_ = 0;
+    current_ = 0;
+  }
+
+  // Wi-Fi callback: one Remote ID frame heard on channel.
+  void note_frame(uint8_t channel) {
+    for (uint8_t i = 0; i < count_; i++) {
+      if (channel_[i] == channel) {
+        frames_[i]++;
+        return;
+      }
+    }
+  }
+
+  // Hop task: picks the channel to listen on next. Stays put when hopping is off.
+  uint8_t next(uint32_t now) {
+    if (!CHANNEL_HOP_ENABLE) return CHANNEL_HOME;
+    update_scores(now);
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < count_; i++) {
+      // Signed difference so pass values may wrap
+      if ((int32_t)(pass_[i] - pass_[best]) < 0) best = i;
+    }
+    pass_[best] += STRIDE / weight(best);
+    visits_[best]++;
+    current_ = best;
+    return channel_[best];
+  }
+
+  uint32_t dwell_ms(uint8_t channel) const {
+    return channel == CHANNEL_HOME ? CHANNEL_HOME_DWELL_MS : CHANNEL_SCAN_DWELL_MS;
+  }
+
+  uint8_t current_channel() const { return channel_[current_]; }
+
+  // Writes {"6":120,"1":0,...}: Remote ID frames heard per channel.
+  int format_frames(char *buf, size_t size) const {
+    int n = snprintf(buf, size, "{");
+    for (uint8_t i = 0; i < count_ && n < (int)size; i++) {
+      n += snprintf(buf + n, size - n, "%s\"%u\":%u", i ? "," : "",
+                    (unsigned)channel_[i], (unsigned)frames_[i]);
+    }
+    if (n < (int)size) n += snprintf(buf + n, size - n, "}");
+    return n;
+  }
+
+  uint8_t count() const { return count_; }
+  uint8_t channel_at(uint8_t i) const { return channel_[i]; }
+  uint32_t frames_at(uint8_t i) const { return frames_[i]; }
+  uint32_t visits_at(uint8_t i) const { return visits_[i]; }
+
+private:
+  static const uint32_t STRIDE = 1UL << 20;
+
+  uint32_t weight(uint8_t i) const {
+    uint32_t base = channel_[i] == CHANNEL_HOME ? CHANNEL_HOME_WEIGHT : 1;
+    uint32_t activity = score_[i] < CHANNEL_WEIGHT_CAP ? score_[i] : CHANNEL_WEIGHT_CAP;
+    return base + activity;
+  }
+
+  void update_scores(uint32_t now) {
+    bool decay = (now - last_decay_) >= CHANNEL_DECAY_MS;
+    if (decay) last_decay_ = now;
+    for (uint8_t i = 0; i < count_; i++) {
+      uint32_t seen = frames_[i];
+      uint32_t fresh = seen - counted_[i];
+      counted_[i] = seen;
+      uint32_t score = score_[i] + fresh;
+      score_[i] = score < 0xFFFF ? score : 0xFFFF;
+      if (decay) score_[i] >>= 1;
+    }
+  }
+
+  uint8_t channel_[MAX_CHANNELS];
+  volatile uint32_t frames_[MAX_CHANNELS];  // Written by the Wi-Fi callback only
+  uint32_t counted_[MAX_CHANNELS];          // frames_ already folded into score_
+  uint16_t score_[MAX_CHANNELS];
+  uint32_t visits_[MAX_CHANNELS];
+  uint32_t pass_[MAX_CHANNELS];
+  uint32_t last_decay_;
+  uint8_t count_;
+  uint8_t current_;
+};
+
+#endif // CHANNEL_SCHEDULER_H
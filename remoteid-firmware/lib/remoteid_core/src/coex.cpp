@@ -0,0 +1,58 @@
+#include <Arduino.h>
+#include <sdkconfig.h>
+#include "ble_scan.h"
+#include "coex.h"
+#include "metrics.h"
+
+#if defined(CONFIG_ESP_COEX_SW_COEXIST_ENABLE) || defined(CONFIG_SW_COEXIST_ENABLE)
+#include <esp_coexist.h>
+#define COEX_PREFERENCE 1
+#else
+#define COEX_PREFERENCE 0
+#endif
+
+static CoexScheduler scheduler;     // Loop task only
+static volatile bool started = false;
+static coex_stats stats;            // Written in the loop task, which also prints the heartbeat
+
+static void set_preference(uint8_t ble_percent) {
+#if COEX_PREFERENCE
+  esp_coex_preference_set(ble_percent < 50 ? ESP_COEX_PREFER_WIFI :
+                          ble_percent > 50 ? ESP_COEX_PREFER_BT : ESP_COEX_PREFER_BALANCE);
+#endif
+}
+
+uint8_t coex_ble_percent() {
+  if (!RID_ENABLE_BLE || RID_COEX_MODE == RID_COEX_OFF) return 0;
+  return scheduler.ble_percent();
+}
+
+void coex_begin() {
+  if (coex_ble_percent()) set_preference(scheduler.ble_percent());
+  started = true;  // Runs on the BLE init task; loop() picks up from here
+}
+
+void coex_poll() {
+  uint8_t pct = coex_ble_percent();
+  if (!started || !pct) return;
+  uint32_t wifi = metrics_frames(RID_SOURCE_NAN) + metrics_frames(RID_SOURCE_BEACON);
+  uint32_t ble = metrics_frames(RID_SOURCE_BLE_LEGACY) + metrics_frames(RID_SOURCE_BLE_EXTENDED);
+  if (scheduler.update(millis(), wifi, ble)) {
+    pct = scheduler.ble_percent();
+#if RID_ENABLE_BLE
+    ble_scan_set_duty(pct);
+#endif
+    set_preference(pct);
+  }
+  stats.mode = RID_COEX_MODE;
+  stats.ble_percent = pct;
+  stats.wifi_listen_ms = scheduler.wifi_listen_ms();
+  stats.ble_listen_ms = scheduler.ble_listen_ms();
+  stats.changes = scheduler.changes();
+}
+
+coex_stats coex_get_stats() {
+  coex_stats s = stats;
+  s.mode = RID_COEX_MODE;
+  return s;
+}
@@ -0,0 +1,34 @@
+/*
+ * Applies the Wi-Fi / BLE airtime split of coex_scheduler.h on builds with
+ * RID_ENABLE_BLE: the BLE scan duty cycle through ble_scan_set_duty(), and
+ * the IDF coexistence preference to match it (Wi-Fi below an even split, BT
+ * above, balanced at it). The heartbeat reports the current BLE share, the
+ * listen time each radio was given and how often adaptive mode moved.
+ */
+
+#ifndef COEX_H
+#define COEX_H
+
+#include <stdint.h>
+#include "coex_scheduler.h"
+
+struct coex_stats {
+  uint8_t  mode;                      // RID_COEX_*
+  uint8_t  ble_percent;               // 0 with RID_COEX_OFF or without BLE
+  uint32_t wifi_listen_ms;
+  uint32_t ble_listen_ms;
+  uint32_t changes;
+};
+
+// BLE share for ble_scan_begin(), 0 to keep the RID_BLE_SCAN_* timing.
+uint8_t coex_ble_percent();
+
+// Sets the coexistence preference. Call once BLE is initialised.
+void coex_begin();
+
+// Moves the split as the detections come in. Call from loop().
+void coex_poll();
+
+coex_stats coex_get_stats();
+
+#endif // COEX_H
@@ -0,0 +1,151 @@
+/*
+ * Wi-Fi / BLE airtime split for the chips that capture both on one 2.4 GHz
+ * radio. The split is the BLE scan duty cycle: the controller listens for
+ * RID_COEX_BLE_INTERVAL_MS * percent / 100 of every scan interval and the
+ * coexistence arbiter gives Wi-Fi the rest. coex.cpp applies it; this class
+ * only decides it.
+ *
+ *   RID_COEX_OFF       the scan timing of ble_scan.h and the IDF coexistence
+ *                      defaults, as before; builds that set their own
+ *                      RID_BLE_SCAN_WINDOW pick this in platformio.ini
+ *   RID_COEX_FIXED     BLE gets RID_COEX_BLE_PERCENT
+ *   RID_COEX_ADAPTIVE  every RID_COEX_PERIOD_MS the BLE share follows where
+ *                      Remote ID frames come from, per unit of listen time
+ *                      so a radio is not rewarded just for having had more of
+ *                      it. Yields decay by half each period; the share moves
+ *                      one step of RID_COEX_LEVELS at a time and never below
+ *                      the lowest, so a quiet radio still hears a new drone.
+ *
+ * Listen times are what the split scheduled while BLE was scanning, not
+ * measured airtime; Wi-Fi also loses the moments the arbiter grants BLE
+ * outside the window.
+ *
+ * Loop task only.
+ */
+
+#ifndef COEX_SCHEDULER_H
+#define COEX_SCHEDULER_H
+
+#include <stdint.h>
+
+#define RID_COEX_OFF      0
+#define RID_COEX_FIXED    1
+#define RID_COEX_ADAPTIVE 2
+
+#ifndef RID_COEX_MODE
+#define RID_COEX_MODE RID_COEX_ADAPTIVE
+#endif
+
+#ifndef RID_COEX_BLE_INTERVAL_MS
+#define RID_COEX_BLE_INTERVAL_MS 100      // Scan interval the window is cut from
+#endif
+
+#ifndef RID_COEX_BLE_PERCENT
+#define RID_COEX_BLE_PERCENT 50           // Fixed mode, and where adaptive starts
+#endif
+
+#ifndef RID_COEX_PERIOD_MS
+#define RID_COEX_PERIOD_MS 5000UL
+#endif
+
+static_assert(RID_COEX_BLE_PERCENT > 0 && RID_COEX_BLE_PERCENT < 100, "both radios need some airtime");
+
+#ifndef RID_COEX_LEVELS
+#define RID_COEX_LEVELS 10, 25, 50, 75, 90  // BLE shares adaptive mode picks from, ascending
+#endif
+
+class CoexScheduler {
+public:
+  static const uint8_t MAX_LEVELS = 8;
+
+  CoexScheduler() {
+    static const uint8_t list[] = { RID_COEX_LEVELS };
+    count_ = 0;
+    for (uint8_t i = 0; i < sizeof(list) && count_ < MAX_LEVELS; i++) {
+      if (list[i] > 0 && list[i] < 100) level_[count_++] = list[i];  // Each radio keeps some air
+    }
+    // Start at the level closest to RID_COEX_BLE_PERCENT
+    current_ = 0;
+    for (uint8_t i = 1; i < count_; i++) {
+      if (distance(level_[i], RID_COEX_BLE_PERCENT) < distance(level_[current_], RID_COEX_BLE_PERCENT)) {
+        current_ = i;
+      }
+    }
+    wifi_counted_ = ble_counted_ = 0;
+    wifi_yield_ = ble_yield_ = 0;
+    wifi_listen_ms_ = ble_listen_ms_ = 0;
+    last_ms_ = last_period_ = 0;
+    changes_ = 0;
+    started_ = false;
+  }
+
+  // Current BLE share of the airtime, in percent.
+  uint8_t ble_percent() const {
+    return RID_COEX_MODE == RID_COEX_ADAPTIVE ? level_[current_] : RID_COEX_BLE_PERCENT;
+  }
+
+  // Loop task, with the running totals of Remote ID frames decoded from each
+  // radio. Returns true when ble_percent() changed and has to be applied.
+  bool update(uint32_t now, uint32_t wifi_frames, uint32_t ble_frames) {
+    if (!started_) {
+      started_ = true;
+      last_ms_ = last_period_ = now;
+      wifi_counted_ = wifi_frames;
+      ble_counted_ = ble_frames;
+      return false;
+    }
+    uint32_t elapsed = now - last_ms_;
+    last_ms_ = now;
+    uint32_t ble_ms = elapsed * ble_percent() / 100;
+    ble_listen_ms_ += ble_ms;
+    wifi_listen_ms_ += elapsed - ble_ms;
+    if (RID_COEX_MODE != RID_COEX_ADAPTIVE || now - last_period_ < RID_COEX_PERIOD_MS) return false;
+    last_period_ = now;
+
+    // Frames per percent of airtime over the period, scaled to keep precision
+    uint32_t pct = ble_percent();
+    wifi_yield_ = wifi_yield_ / 2 + (wifi_frames - wifi_counted_) * 256 / (100 - pct);
+    ble_yield_ = ble_yield_ / 2 + (ble_frames - ble_counted_) * 256 / pct;
+    wifi_counted_ = wifi_frames;
+    ble_counted_ = ble_frames;
+    uint32_t total = wifi_yield_ + ble_yield_;
+    if (!total) return false;  // Nothing heard: no reason to move
+
+    uint32_t target = (uint32_t)((uint64_t)ble_yield_ * 100 / total);
+    uint8_t step = current_;
+    if (current_ + 1 < count_ && target > level_[current_] &&
+        distance(level_[current_ + 1], target) < distance(level_[current_], target)) {
+      step = current_ + 1;
+    } else if (current_ > 0 && target < level_[current_] &&
+               distance(level_[current_ - 1], target) < distance(level_[current_], target)) {
+      step = current_ - 1;
+    }
+    if (step == current_) return false;
+    current_ = step;
+    changes_++;
+    return true;
+  }
+
+  uint32_t wifi_listen_ms() const { return wifi_listen_ms_; }
+  uint32_t ble_listen_ms() const { return ble_listen_ms_; }
+  uint32_t changes() const { return changes_; }
+
+private:
+  static uint32_t distance(uint32_t a, uint32_t b) { return a > b ? a - b : b - a; }
+
+  uint8_t level_[MAX_LEVELS];
+  uint8_t count_;
+  uint8_t current_;
+  uint32_t wifi_counted_;                 // Frame totals already folded into the yields
+  uint32_t ble_counted_;
+  uint32_t wifi_yield_;
+  uint32_t ble_yield_;
+  uint32_t wifi_listen_ms_;
+  uint32_t ble_listen_ms_;
+  uint32_t last_ms_;
+  uint32_t last_period_;
+  uint32_t changes_;
+  bool started_;
+};
+
+#endif // COEX_SCHEDULER_H
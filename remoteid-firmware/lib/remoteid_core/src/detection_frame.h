@@ -0,0 +1,276 @@
+/*
+ * Compact binary detection record for the USB serial link.
+ *
+ * Frame layout (multi-byte fields little endian):
+ *
+ *   0xA5 0x5A | type | len | payload[len] | crc16
+ *
+ * The sync bytes are not ASCII, so frames can share the port with JSON and
+ * text lines and a host can find them again after noise. crc16 is
+ * CRC-16/CCITT-FALSE over type, len and payload.
+ *
+ * A detection payload (type 0x01) is the MAC (6 bytes), RSSI (int8) and then
+ * one section per message group carried, each as tag | len | body with the
+ * tag being the ODID message type:
+ *
+ *   0 Basic ID     ua_type u8, id chars
+ *   1 Location     lat i32, lon i32 (1e-7 degrees), altitude i16 (m)
+ *   2 Auth         auth_type u8, last_page u8, pages u16 (bit n = page n seen)
+ *   3 Self ID      description chars
+ *   4 System       pilot lat i32, pilot lon i32 (1e-7 degrees)
+ *   5 Operator ID  id chars
+ *   6 Location ext height i16 (m), heading u16 (degrees), speed u8 (m/s),
+ *                  speed_vertical i8 (m/s), status u8
+ *   7 Types        id_type u8, operator_id_type u8, desc_type u8
+ *   8 RX time      u64, microseconds since the Unix epoch once the node is
+ *                  synced, else since boot (time_sync.h)
+ *
+ * Type 0x02 has the same payload and is a detection replayed from the flash
+ * backlog (flash_log.h). Those carry tags 0-8 in full, with tag 8 taken from
+ * the node's clock when it was logged.
+ *
+ * Only the groups being reported are present. Hosts skip tags they do not know.
+ * Tags 6 and 7 carry what the USB frames leave out; only ESP-NOW batches
+ * (espnow_link.h) send them, so a collector can rebuild the full record with
+ * detection_frame_parse(). Tag 8 is only sent on USB.
+ */
+
+#ifndef DETECTION_FRAME_H
+#define DETECTION_FRAME_H
+
+#include <stdint.h>
+#include <string.h>
+#include "opendroneid.h"
+
+#define DETECTION_FRAME_SYNC0     0xA5
+#define DETECTION_FRAME_SYNC1     0x5A
+#define DETECTION_FRAME_DETECTION 0x01
+#define DETECTION_FRAME_STORED    0x02  // A detection replayed from the flash backlog
+#define DETECTION_FRAME_MAX       144  // Header, every section at full length, CRC
+
+static inline uint16_t detection_frame_crc16(const uint8_t *data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++)
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+class DetectionFrame {
+public:
+  DetectionFrame(const uint8_t *mac, int rssi, uint8_t type = DETECTION_FRAME_DETECTION) {
+    buf_[0] = DETECTION_FRAME_SYNC0;
+    buf_[1] = DETECTION_FRAME_SYNC1;
+    buf_[2] = type;
+    len_ = HEADER;
+    put(mac, 6);
+    put_u8((uint8_t)(int8_t)rssi);
+  }
+
+  void basic_id(uint8_t ua_type, const char *id) {
+    size_t n = strnlen(id, 20);
+    if (!open_section(0, 1 + n)) return;
+    put_u8(ua_type);
+    put(id, n);
+  }
+
+  void location(int32_t lat_e7, int32_t lon_e7, int altitude) {
+    if (!open_section(1, 10)) return;
+    put_i32(lat_e7);
+    put_i32(lon_e7);
+    put_i16(altitude);
+  }
+
+  void auth(uint8_t auth_type, uint8_t last_page, uint16_t pages) {
+    if (!open_section(2, 4)) return;
+    put_u8(auth_type);
+    put_u8(last_page);
+    put_u8(pages & 0xFF);
+    put_u8(pages >> 8);
+  }
+
+  void self_id(const char *description) {
+    size_t n = strnlen(description, 23);
+    if (!open_section(3, n)) return;
+    put(description, n);
+  }
+
+  void system(int32_t pilot_lat_e7, int32_t pilot_lon_e7) {
+    if (!open_section(4, 8)) return;
+    put_i32(pilot_lat_e7);
+    put_i32(pilot_lon_e7);
+  }
+
+  void operator_id(const char *id) {
+    size_t n = strnlen(id, 20);
+    if (!open_section(5, n)) return;
+    put(id, n);
+  }
+
+  void location_ext(int height_agl, uint16_t heading, uint8_t speed, int8_t speed_vertical, uint8_t status) {
+    if (!open_section(6, 7)) return;
+    put_i16(height_agl);
+    put_u8(heading & 0xFF);
+    put_u8(heading >> 8);
+    put_u8(speed);
+    put_u8((uint8_t)speed_vertical);
+    put_u8(status);
+  }
+
+  void types(uint8_t id_type, uint8_t operator_id_type, uint8_t desc_type) {
+    if (!open_section(7, 3)) return;
+    put_u8(id_type);
+    put_u8(operator_id_type);
+    put_u8(desc_type);
+  }
+
+  void rx_time(int64_t us) {
+    if (!open_section(8, 8)) return;
+    uint64_t u = (uint64_t)us;
+    for (int i = 0; i < 8; i++) put_u8((u >> (8 * i)) & 0xFF);
+  }
+
+  // Seals the frame and returns its total length.
+  size_t finish() {
+    buf_[3] = (uint8_t)(len_ - HEADER);
+    uint16_t crc = detection_frame_crc16(&buf_[2], len_ - 2);
+    buf_[len_++] = crc & 0xFF;
+    buf_[len_++] = crc >> 8;
+    return len_;
+  }
+
+  const uint8_t *data() const { return buf_; }
+
+private:
+  static const size_t HEADER = 4;
+
+  bool open_section(uint8_t tag, size_t body) {
+    if (len_ + 2 + body + 2 > sizeof(buf_)) return false;
+    put_u8(tag);
+    put_u8((uint8_t)body);
+    return true;
+  }
+
+  void put(const void *src, size_t n) {
+    memcpy(&buf_[len_], src, n);
+    len_ += n;
+  }
+  void put_u8(uint8_t v) { buf_[len_++] = v; }
+  void put_i16(int v) {
+    if (v > INT16_MAX) v = INT16_MAX;
+    if (v < INT16_MIN) v = INT16_MIN;
+    put_u8((uint16_t)v & 0xFF);
+    put_u8((uint16_t)v >> 8);
+  }
+  void put_i32(int32_t v) {
+    uint32_t u = (uint32_t)v;
+    for (int i = 0; i < 4; i++) put_u8((u >> (8 * i)) & 0xFF);
+  }
+
+  uint8_t buf_[DETECTION_FRAME_MAX];
+  size_t len_;
+};
+
+static inline int32_t detection_frame_i32(const uint8_t *p) {
+  return (int32_t)((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+}
+
+static inline void detection_frame_text(char *dst, size_t size, const uint8_t *src, size_t n) {
+  if (n > size - 1) n = size - 1;
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+// Reads the detection frame at the start of buf back into mac, rssi and lean
+// as if its groups had been decoded off the air: Valid has a bit per section
+// 0-5, and fields the frame does not carry (no tag 6 or 7) come out unknown
+// or zero. Auth arrives without page data, so AuthPageData is cleared.
+// Returns the frame's length, 0 if buf does not start with a whole detection
+// frame with a good CRC.
+static inline size_t detection_frame_parse(const uint8_t *buf, size_t len, uint8_t *mac, int8_t *rssi,
+                                           ODID_Lean_data *lean) {
+  if (len < 4 + 7 + 2 || buf[0] != DETECTION_FRAME_SYNC0 || buf[1] != DETECTION_FRAME_SYNC1 ||
+      buf[2] != DETECTION_FRAME_DETECTION) {
+    return 0;
+  }
+  size_t payload = buf[3];
+  size_t total = 4 + payload + 2;
+  if (payload < 7 || total > len) return 0;
+  uint16_t crc = (uint16_t)(buf[4 + payload] | buf[5 + payload] << 8);
+  if (crc != detection_frame_crc16(&buf[2], 2 + payload)) return 0;
+
+  odid_initLeanData(lean);
+  memset(lean->AuthPageData, 0, sizeof(lean->AuthPageData));
+  lean->Height = -1000;
+  lean->Direction = 361;
+  lean->SpeedHorizontal = 25500;
+  lean->SpeedVertical = 6300;
+  memcpy(mac, &buf[4], 6);
+  *rssi = (int8_t)buf[10];
+  const uint8_t *p = &buf[11], *end = &buf[4 + payload];
+  while (end - p >= 2) {
+    uint8_t tag = p[0];
+    size_t n = p[1];
+    const uint8_t *body = p + 2;
+    if ((size_t)(end - body) < n) return 0;
+    p = body + n;
+    switch (tag) {
+    case 0:
+      if (n < 1) break;
+      lean->UAType = body[0];
+      detection_frame_text(lean->UASID, sizeof(lean->UASID), body + 1, n - 1);
+      lean->Valid |= ODID_LEAN_TYPE(ODID_MESSAGETYPE_BASIC_ID);
+      break;
+    case 1:
+      if (n < 10) break;
+      lean->Latitude = detection_frame_i32(body);
+      lean->Longitude = detection_frame_i32(body + 4);
+      lean->AltitudeGeo = (int16_t)(body[8] | body[9] << 8);
+      lean->Valid |= ODID_LEAN_TYPE(ODID_MESSAGETYPE_LOCATION);
+      break;
+    case 2:
+      if (n < 4) break;
+      lean->AuthType = body[0];
+      lean->AuthLastPageIndex = body[1];
+      lean->AuthPages = (uint16_t)(body[2] | body[3] << 8);
+      lean->Valid |= ODID_LEAN_TYPE(ODID_MESSAGETYPE_AUTH);
+      break;
+    case 3:
+      detection_frame_text(lean->Desc, sizeof(lean->Desc), body, n);
+      lean->Valid |= ODID_LEAN_TYPE(ODID_MESSAGETYPE_SELF_ID);
+      break;
+    case 4:
+      if (n < 8) break;
+      lean->OperatorLatitude = detection_frame_i32(body);
+      lean->OperatorLongitude = detection_frame_i32(body + 4);
+      lean->Valid |= ODID_LEAN_TYPE(ODID_MESSAGETYPE_SYSTEM);
+      break;
+    case 5:
+      detection_frame_text(lean->OperatorId, sizeof(lean->OperatorId), body, n);
+      lean->Valid |= ODID_LEAN_TYPE(ODID_MESSAGETYPE_OPERATOR_ID);
+      break;
+    case 6:
+      if (n < 7) break;
+      lean->Height = (int16_t)(body[0] | body[1] << 8);
+      lean->Direction = (uint16_t)(body[2] | body[3] << 8);
+      // Back to cm/s; the merge divides by 100 again
+      lean->SpeedHorizontal = (uint16_t)(body[4] * 100);
+      lean->SpeedVertical = (int16_t)((int8_t)body[5] * 100);
+      lean->Status = body[6];
+      break;
+    case 7:
+      if (n < 3) break;
+      lean->IDType = body[0];
+      lean->OperatorIdType = body[1];
+      lean->DescType = body[2];
+      break;
+    default:
+      break;
+    }
+  }
+  return total;
+}
+
+#endif // DETECTION_FRAME_H
@@ -0,0 +1,170 @@
+#include <Arduino.h>
+#include <esp_idf_version.h>
+#include <esp_now.h>
+#include <esp_wifi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "capture.h"
+#include "espnow_link.h"
+
+#define SEND_TIMEOUT_MS 100  // A send without its callback by then counts as failed
+
+struct espnow_batch {
+  uint8_t len;
+  uint8_t data[ESPNOW_BATCH_MAX];
+};
+
+static const uint8_t peer[6] = { RID_ESPNOW_PEER };
+
+// Node state, shared by the printer (submit), loop (poll), the hop task and
+// the send callback in the Wi-Fi task; all under lock. queue[tail] is the
+// batch in flight while inFlight is set, and is only freed by its callback
+// or the timeout. ESP-NOW calls back once per accepted esp_now_send(), in
+// order, so sends are numbered and callbacks counted: a callback whose
+// number is not flightSeq belongs to a send that already timed out.
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static espnow_batch filling;
+static uint8_t fillCount = 0;
+static uint32_t fillMs = 0;
+static espnow_batch queue[RID_ESPNOW_QUEUE];
+static uint8_t queueHead = 0;
+static uint8_t queueTail = 0;
+static uint8_t queued = 0;
+static uint8_t seq = 0;
+static bool onChannel = false;
+static volatile bool inFlight = false;
+static uint32_t sendMs = 0;
+static uint32_t sendsIssued = 0;
+static uint32_t callbacks = 0;
+static uint32_t flightSeq = 0;      // sendsIssued of the batch in flight
+static espnow_stats stats;
+
+// Moves the batch being filled to the queue. Caller holds lock.
+static void seal() {
+  if (!fillCount) return;
+  if (queued == RID_ESPNOW_QUEUE) {
+    stats.dropped++;
+  } else {
+    filling.data[0] = ESPNOW_BATCH_MAGIC0;
+    filling.data[1] = ESPNOW_BATCH_MAGIC1;
+    filling.data[2] = ESPNOW_BATCH_VERSION;
+    filling.data[3] = seq++;
+    filling.data[4] = fillCount;
+    queue[queueHead] = filling;
+    queueHead = (uint8_t)((queueHead + 1) % RID_ESPNOW_QUEUE);
+    queued++;
+  }
+  fillCount = 0;
+}
+
+// Ends the send of queue[tail]. Caller holds lock.
+static void finish_send(bool ok) {
+  if (!inFlight) return;
+  inFlight = false;
+  queueTail = (uint8_t)((queueTail + 1) % RID_ESPNOW_QUEUE);
+  queued--;
+  if (ok) stats.sent++;
+  else stats.failed++;
+}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void on_sent(const esp_now_send_info_t *info, esp_now_send_status_t status) {
+#else
+static void on_sent(const uint8_t *mac, esp_now_send_status_t status) {
+#endif
+  portENTER_CRITICAL(&lock);
+  if (++callbacks == flightSeq) finish_send(status == ESP_NOW_SEND_SUCCESS);
+  else stats.late++;
+  portEXIT_CRITICAL(&lock);
+}
+
+// Runs in the Wi-Fi task, like the promiscuous callback.
+static void on_received(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+  if (len < ESPNOW_BATCH_HEADER || data[0] != ESPNOW_BATCH_MAGIC0 || data[1] != ESPNOW_BATCH_MAGIC1) return;
+  stats.received++;
+  capture_espnow(info->src_addr, info->rx_ctrl ? info->rx_ctrl->rssi : 0, data, len);
+}
+
+void espnow_begin() {
+  if (RID_ESPNOW == RID_ESPNOW_OFF) return;
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("{\"espnow\":\"init failed\"}");
+    return;
+  }
+  if (RID_ESPNOW == RID_ESPNOW_COLLECTOR) {
+    esp_now_register_recv_cb(on_received);
+    return;
+  }
+  esp_now_peer_info_t info = {};
+  memcpy(info.peer_addr, peer, sizeof(peer));
+  info.channel = 0;  // Whatever the radio is on; sends are held off RID_ESPNOW_CHANNEL
+  info.ifidx = WIFI_IF_STA;
+  info.encrypt = false;
+  esp_now_add_peer(&info);
+  esp_now_register_send_cb(on_sent);
+  portENTER_CRITICAL(&lock);
+  onChannel = RID_ESPNOW_CHANNEL == CHANNEL_HOME;  // capture_begin() left the radio there
+  portEXIT_CRITICAL(&lock);
+}
+
+void espnow_submit(const uint8_t *frame, size_t len) {
+  if (RID_ESPNOW != RID_ESPNOW_NODE || len > ESPNOW_BATCH_MAX - ESPNOW_BATCH_HEADER) return;
+  portENTER_CRITICAL(&lock);
+  if (fillCount && filling.len + len > ESPNOW_BATCH_MAX) seal();
+  if (!fillCount) {
+    filling.len = ESPNOW_BATCH_HEADER;
+    fillMs = millis();
+  }
+  memcpy(filling.data + filling.len, frame, len);
+  filling.len = (uint8_t)(filling.len + len);
+  fillCount++;
+  stats.frames++;
+  portEXIT_CRITICAL(&lock);
+}
+
+void espnow_poll() {
+  if (RID_ESPNOW != RID_ESPNOW_NODE) return;
+  uint32_t now = millis();
+  portENTER_CRITICAL(&lock);
+  if (fillCount && now - fillMs >= RID_ESPNOW_BATCH_MS) seal();
+  if (inFlight && now - sendMs > SEND_TIMEOUT_MS) finish_send(false);
+  if (!onChannel || inFlight || !queued) {
+    portEXIT_CRITICAL(&lock);
+    return;
+  }
+  inFlight = true;
+  sendMs = now;
+  flightSeq = ++sendsIssued;  // Before the send: its callback may run before esp_now_send() returns
+  const espnow_batch *batch = &queue[queueTail];
+  portEXIT_CRITICAL(&lock);
+  // The slot stays put until finish_send(), so it is safe to read unlocked
+  if (esp_now_send(peer, batch->data, batch->len) != ESP_OK) {
+    portENTER_CRITICAL(&lock);
+    sendsIssued--;  // Refused, so no callback will come for it
+    flightSeq = 0;
+    finish_send(false);
+    portEXIT_CRITICAL(&lock);
+  }
+}
+
+void espnow_channel_leave(uint8_t channel) {
+  if (RID_ESPNOW != RID_ESPNOW_NODE || channel != RID_ESPNOW_CHANNEL) return;
+  portENTER_CRITICAL(&lock);
+  onChannel = false;
+  portEXIT_CRITICAL(&lock);
+  for (uint32_t waited = 0; inFlight && waited < RID_ESPNOW_DRAIN_MS; waited++) vTaskDelay(pdMS_TO_TICKS(1));
+}
+
+void espnow_channel_enter(uint8_t channel) {
+  if (RID_ESPNOW != RID_ESPNOW_NODE || channel != RID_ESPNOW_CHANNEL) return;
+  portENTER_CRITICAL(&lock);
+  onChannel = true;
+  portEXIT_CRITICAL(&lock);
+}
+
+espnow_stats espnow_get_stats() {
+  portENTER_CRITICAL(&lock);
+  espnow_stats s = stats;
+  portEXIT_CRITICAL(&lock);
+  return s;
+}
@@ -0,0 +1,144 @@
+/*
+ * ESP-NOW link between scanner nodes and a collector, for sites where the
+ * nodes are within Wi-Fi range of one board on a host. The UART mesh carries
+ * a few lines a minute; one ESP-NOW frame carries several detections.
+ *
+ * With RID_ESPNOW_NODE the printer hands every delta it prints to
+ * espnow_submit() as a DetectionFrame with the extra tags 6 and 7
+ * (detection_frame.h). Frames are packed into a batch of up to
+ * ESPNOW_BATCH_MAX bytes, and a batch is sealed once the next frame does not
+ * fit or RID_ESPNOW_BATCH_MS after its first frame. espnow_poll() sends the
+ * sealed batches to RID_ESPNOW_PEER one at a time, waiting for each send
+ * callback; RID_ESPNOW_QUEUE batches wait at most and newer ones are dropped
+ * beyond that.
+ *
+ * Batch layout:
+ *
+ *   'R' 'N' | version | seq | count | count detection frames, back to back
+ *
+ * With RID_ESPNOW_COLLECTOR each batch received goes into frameRing like a
+ * captured frame (capture_espnow()), and the decode task feeds its
+ * detections to track_uas(). The collector's own USB stream then covers every
+ * node's drones, merged per MAC with what it hears itself.
+ *
+ * The link uses RID_ESPNOW_CHANNEL, the home channel unless overridden, so a
+ * collector parked there (CHANNEL_HOP_ENABLE=0) keeps capturing Remote ID
+ * while it listens and a node never leaves home just to send. A node sends
+ * only while the radio is on that channel; before the hop task moves away
+ * it calls espnow_channel_leave(), which holds new sends and waits up to
+ * RID_ESPNOW_DRAIN_MS for the one in flight, so no frame goes out on a
+ * channel the collector is not on.
+ *
+ * Auth page data is not relayed; the collector only gets the page set.
+ */
+
+#ifndef ESPNOW_LINK_H
+#define ESPNOW_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "channel_scheduler.h"
+#include "detection_frame.h"
+
+#define RID_ESPNOW_OFF       0
+#define RID_ESPNOW_NODE      1
+#define RID_ESPNOW_COLLECTOR 2
+
+#ifndef RID_ESPNOW
+#define RID_ESPNOW RID_ESPNOW_OFF
+#endif
+
+#ifndef RID_ESPNOW_PEER
+#define RID_ESPNOW_PEER 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF  // Collector MAC; broadcast by default
+#endif
+
+#ifndef RID_ESPNOW_CHANNEL
+#define RID_ESPNOW_CHANNEL CHANNEL_HOME
+#endif
+
+#ifndef RID_ESPNOW_BATCH_MS
+#define RID_ESPNOW_BATCH_MS 100UL       // Longest a frame waits for others to share its batch
+#endif
+
+#ifndef RID_ESPNOW_QUEUE
+#define RID_ESPNOW_QUEUE 8              // Sealed batches waiting to be sent
+#endif
+
+#ifndef RID_ESPNOW_DRAIN_MS
+#define RID_ESPNOW_DRAIN_MS 10          // Longest a hop away waits for a send
+#endif
+
+#define ESPNOW_BATCH_MAX     250        // ESP_NOW_MAX_DATA_LEN
+#define ESPNOW_BATCH_HEADER  5
+#define ESPNOW_BATCH_MAGIC0  'R'
+#define ESPNOW_BATCH_MAGIC1  'N'
+#define ESPNOW_BATCH_VERSION 1
+
+static_assert(ESPNOW_BATCH_HEADER + DETECTION_FRAME_MAX <= ESPNOW_BATCH_MAX, "a frame must fit in a batch");
+
+struct espnow_stats {
+  uint32_t frames;                    // Detection frames batched (node)
+  uint32_t sent;                      // Batches sent (node)
+  uint32_t failed;                    // Batches the peer did not acknowledge (node)
+  uint32_t dropped;                   // Batches dropped with the queue full (node)
+  uint32_t late;                      // Callbacks for sends that had already timed out (node)
+  uint32_t received;                  // Batches received (collector)
+};
+
+// Walks the detection frames of a received batch. Nothing here touches the SDK.
+class EspNowBatchReader {
+public:
+  EspNowBatchReader(const uint8_t *data, size_t len) : data_(data), len_(len), pos_(ESPNOW_BATCH_HEADER), left_(0) {
+    if (len >= ESPNOW_BATCH_HEADER && data[0] == ESPNOW_BATCH_MAGIC0 && data[1] == ESPNOW_BATCH_MAGIC1 &&
+        data[2] == ESPNOW_BATCH_VERSION) {
+      left_ = data[4];
+    } else {
+      pos_ = len + 1;
+    }
+  }
+
+  bool valid() const { return pos_ <= len_; }
+
+  // Parses the next frame into mac, rssi and lean. False after the last one
+  // or at a frame that does not parse.
+  bool next(uint8_t *mac, int8_t *rssi, ODID_Lean_data *lean) {
+    if (!left_ || pos_ >= len_) return false;
+    size_t n = detection_frame_parse(data_ + pos_, len_ - pos_, mac, rssi, lean);
+    if (!n) {
+      pos_ = len_ + 1;
+      return false;
+    }
+    pos_ += n;
+    left_--;
+    return true;
+  }
+
+  // True once every frame the header announced was read.
+  bool done() const { return valid() && left_ == 0; }
+
+private:
+  const uint8_t *data_;
+  size_t len_;
+  size_t pos_;
+  uint8_t left_;
+};
+
+// Brings up ESP-NOW in the mode RID_ESPNOW picks; nothing when it is off.
+// Call after capture_begin().
+void espnow_begin();
+
+// Node, printer task: adds one sealed detection frame to the open batch.
+void espnow_submit(const uint8_t *frame, size_t len);
+
+// Node: seals an old batch and sends the next one if the radio is on
+// RID_ESPNOW_CHANNEL and no send is in flight. Call from loop().
+void espnow_poll();
+
+// Hop task, around each channel switch: leaving RID_ESPNOW_CHANNEL holds
+// sends and drains the one in flight, entering it lets them go again.
+void espnow_channel_leave(uint8_t channel);
+void espnow_channel_enter(uint8_t channel);
+
+espnow_stats espnow_get_stats();
+
+#endif // ESPNOW_LINK_H
@@ -0,0 +1,251 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_partition.h>
+#include "detection_frame.h"
+#include "flash_log.h"
+#include "usb_tx.h"
+
+#define SECTOR_SIZE       4096
+#define BLOCKS_PER_SECTOR (SECTOR_SIZE / RID_LOG_BLOCK)
+#define BLOCK_MAGIC       0x4C52    // "RL"
+
+struct block_header {
+  uint16_t magic;
+  uint16_t used;                      // Frame bytes after the header
+  uint32_t seq;
+  uint16_t crc;                       // detection_frame_crc16() of those bytes
+  uint16_t reserved;
+};
+
+static_assert(sizeof(block_header) == 12, "block header layout changed");
+
+#define BLOCK_DATA (RID_LOG_BLOCK - sizeof(block_header))
+
+static const esp_partition_t *part = nullptr;
+static uint32_t blocks = 0;            // In the partition
+static uint32_t head = 0;              // Next block to write
+static uint32_t nextSeq = 1;
+static uint32_t confirmed = 0;         // Highest sequence a host took
+
+// The block being filled
+static uint8_t fill[RID_LOG_BLOCK];
+static uint16_t fillUsed = 0;
+static uint32_t fillMs = 0;
+
+// Drain in progress: the block to look at next and how many are left
+static bool draining = false;
+static uint32_t drainBlock = 0;
+static uint32_t drainLeft = 0;
+static uint32_t drainFrames = 0;
+static uint32_t drainLast = 0;
+static uint8_t drainBuf[RID_LOG_BLOCK];
+
+// Set from loop() by host commands
+static volatile uint32_t hostMs = 0;
+static volatile bool hostSeen = false;
+static volatile bool drainRequested = false;
+static volatile uint32_t confirmSeq = 0;
+
+static flash_log_stats stats;
+
+static bool read_header(uint32_t block, block_header *h) {
+  return esp_partition_read(part, block * RID_LOG_BLOCK, h, sizeof(*h)) == ESP_OK;
+}
+
+void flash_log_begin() {
+  if (!RID_LOG_ENABLE) return;
+  part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, RID_LOG_PARTITION);
+  if (!part || part->size < 2 * SECTOR_SIZE) {
+    part = nullptr;
+    Serial.println("{\"log\":\"no partition\"}");
+    return;
+  }
+  uint32_t sectors = part->size / SECTOR_SIZE;
+  blocks = sectors * BLOCKS_PER_SECTOR;
+
+  // The head sector starts with the highest sequence
+  bool found = false;
+  uint32_t headSector = 0, headSeq = 0;
+  block_header h;
+  for (uint32_t s = 0; s < sectors; s++) {
+    if (!read_header(s * BLOCKS_PER_SECTOR, &h) || h.magic != BLOCK_MAGIC) continue;
+    if (!found || (int32_t)(h.seq - headSeq) > 0) {
+      found = true;
+      headSector = s;
+      headSeq = h.seq;
+    }
+  }
+  if (found) {
+    // First unwritten block of the head sector, or the next sector
+    uint32_t b = 1;
+    uint32_t lastSeq = headSeq;
+    for (; b < BLOCKS_PER_SECTOR; b++) {
+      if (!read_header(headSector * BLOCKS_PER_SECTOR + b, &h) || h.magic != BLOCK_MAGIC) break;
+      lastSeq = h.seq;
+    }
+    head = (headSector * BLOCKS_PER_SECTOR + b) % blocks;
+    nextSeq = lastSeq + 1;
+  }
+
+  Preferences prefs;
+  if (prefs.begin("remoteid", true)) {
+    confirmed = prefs.getUInt("log_confirmed", 0);
+    prefs.end();
+  }
+  if ((int32_t)(confirmed - (nextSeq - 1)) > 0) confirmed = nextSeq - 1;  // A new ring
+  stats.sectors = sectors;
+  Serial.printf("{\"log\":{\"sectors\":%u,\"head\":%u,\"next_seq\":%u,\"confirmed\":%u}}\n",
+                (unsigned)sectors, (unsigned)head, (unsigned)nextSeq, (unsigned)confirmed);
+}
+
+void flash_log_note_host() {
+  hostMs = millis();
+  hostSeen = true;
+}
+
+bool flash_log_active() {
+  return part && (!hostSeen || millis() - hostMs > RID_LOG_HOST_TIMEOUT_MS);
+}
+
+// Writes the RAM block to flash at head, erasing the sector first when head
+// is at its start.
+static void write_block() {
+  if (!fillUsed) return;
+  block_header h = {BLOCK_MAGIC, fillUsed, nextSeq, detection_frame_crc16(fill + sizeof(h), fillUsed), 0};
+  memcpy(fill, &h, sizeof(h));
+  uint32_t offset = head * RID_LOG_BLOCK;
+  bool ok = true;
+  if (head % BLOCKS_PER_SECTOR == 0) {
+    ok = esp_partition_erase_range(part, offset, SECTOR_SIZE) == ESP_OK;
+    stats.erases++;
+  }
+  // Erased bytes write as whole RID_LOG_BLOCK; the unused tail stays 0xFF
+  memset(fill + sizeof(h) + fillUsed, 0xFF, BLOCK_DATA - fillUsed);
+  if (ok) ok = esp_partition_write(part, offset, fill, RID_LOG_BLOCK) == ESP_OK;
+  if (ok) stats.blocks++;
+  else stats.failed++;
+  head = (head + 1) % blocks;
+  nextSeq++;
+  fillUsed = 0;
+}
+
+void flash_log_append(const uint8_t *frame, size_t len) {
+  if (!part || len > BLOCK_DATA) return;
+  if (fillUsed + len > BLOCK_DATA) write_block();
+  if (!fillUsed) fillMs = millis();
+  memcpy(fill + sizeof(block_header) + fillUsed, frame, len);
+  fillUsed = (uint16_t)(fillUsed + len);
+  stats.frames++;
+}
+
+static void confirm(uint32_t seq) {
+  if ((int32_t)(seq - confirmed) <= 0 || (int32_t)(seq - nextSeq) >= 0) return;
+  confirmed = seq;
+  Preferences prefs;
+  if (prefs.begin("remoteid", false)) {
+    prefs.putUInt("log_confirmed", confirmed);
+    prefs.end();
+  }
+}
+
+// Queues a {"drain":...} line on the USB arena. False if it is full.
+static bool drain_line(const char *key, uint32_t a, const char *key2, uint32_t b) {
+  char *out = usb_tx_reserve();
+  if (!out) return false;
+  int n = snprintf(out, RID_USB_TX_RECORD_MAX, "{\"drain\":{\"%s\":%u,\"%s\":%u}}\n", key, (unsigned)a, key2,
+                   (unsigned)b);
+  usb_tx_commit(n, USB_TX_NO_CAPTURE);
+  return true;
+}
+
+static void start_drain() {
+  write_block();  // What is still in RAM goes out too
+  uint32_t pending = nextSeq - 1 - confirmed;
+  if (pending > blocks) pending = blocks;
+  if (!drain_line("start", nextSeq - pending, "pending", pending)) return;  // Past a lap, the oldest kept
+  drainRequested = false;
+  draining = true;
+  drainLeft = pending;
+  drainBlock = (head + blocks - pending) % blocks;
+  drainFrames = 0;
+  drainLast = confirmed;
+}
+
+// Moves the drain along by whole blocks while the arena has room.
+static void continue_drain() {
+  // Ends of the records a block is cut into; every frame is one at most
+  static uint16_t cut[BLOCK_DATA / 6 + 1];
+  for (int skipped = 0; drainLeft && skipped < RID_LOG_DRAIN_SKIP; skipped++) {
+    if (usb_tx_room() == 0) return;
+    block_header *h = (block_header *)drainBuf;
+    uint32_t block = drainBlock;
+    drainBlock = (drainBlock + 1) % blocks;
+    drainLeft--;
+    if (esp_partition_read(part, block * RID_LOG_BLOCK, drainBuf, RID_LOG_BLOCK) != ESP_OK) continue;
+    if (h->magic != BLOCK_MAGIC || h->used > BLOCK_DATA || (int32_t)(h->seq - confirmed) <= 0) continue;
+    const uint8_t *data = drainBuf + sizeof(block_header);
+    if (detection_frame_crc16(data, h->used) != h->crc) continue;
+    // Whole frames per record, up to RID_LOG_DRAIN_RECORD, so each fits
+    // the serial driver in one write
+    uint16_t cuts = 0, frames = 0;
+    size_t start = 0, pos = 0;
+    while (pos + 4 <= h->used) {
+      size_t end = pos + 4 + data[pos + 3] + 2;
+      if (end > h->used) break;
+      if (end - start > RID_LOG_DRAIN_RECORD && pos > start) {
+        cut[cuts++] = (uint16_t)pos;
+        start = pos;
+      }
+      pos = end;
+      frames++;
+    }
+    if (pos > start) cut[cuts++] = (uint16_t)pos;
+    if (usb_tx_room() < cuts) {
+      // Not all of it fits now: the same block again on the next pass
+      drainBlock = block;
+      drainLeft++;
+      return;
+    }
+    start = 0;
+    for (uint16_t i = 0; i < cuts; i++) {
+      char *out = usb_tx_reserve();
+      memcpy(out, data + start, cut[i] - start);
+      usb_tx_commit(cut[i] - start, USB_TX_NO_CAPTURE);
+      start = cut[i];
+    }
+    drainFrames += frames;
+    drainLast = h->seq;
+  }
+  if (drainLeft) return;
+  if (drain_line("end", drainLast, "frames", drainFrames)) draining = false;
+}
+
+uint32_t flash_log_service() {
+  if (!part) return 0;
+  if (confirmSeq) {
+    confirm(confirmSeq);
+    confirmSeq = 0;
+  }
+  if (fillUsed && millis() - fillMs >= RID_LOG_FLUSH_MS) write_block();
+  if (drainRequested && !draining) start_drain();
+  if (draining) continue_drain();
+  if (draining || drainRequested) return RID_USB_TX_FLUSH_MS;
+  if (fillUsed) return RID_LOG_FLUSH_MS - (millis() - fillMs);
+  return 0;
+}
+
+void flash_log_request_drain() {
+  drainRequested = true;
+}
+
+void flash_log_confirm(uint32_t seq) {
+  confirmSeq = seq;
+}
+
+flash_log_stats flash_log_get_stats() {
+  flash_log_stats s = stats;
+  uint32_t pending = nextSeq - 1 - confirmed;
+  s.pending = pending > blocks ? blocks : pending;
+  s.active = flash_log_active();
+  return s;
+}
@@ -0,0 +1,100 @@
+/*
+ * Flash backlog of detections for when no host is listening. While no host
+ * command arrived for RID_LOG_HOST_TIMEOUT_MS (the mappers send TIME every
+ * few seconds), the printer also appends each delta as a DetectionFrame of
+ * type DETECTION_FRAME_STORED to a ring in a raw data partition, and a host
+ * that comes back asks for the backlog with "DRAIN".
+ *
+ * Flash layout: RID_LOG_PARTITION is cut into 4 KB sectors of RID_LOG_BLOCK
+ * byte blocks. A block is written once, whole, when it is full or has held
+ * frames for RID_LOG_FLUSH_MS, and starts with a header (magic, bytes used,
+ * a sequence number counting blocks since the ring was created, CRC-16 of
+ * the frames). A sector is erased just before its first block is written,
+ * so the ring wears every sector evenly and each one once per lap.
+ *
+ * flash_log_begin() finds the write position from the first block header of
+ * every sector (the one with the highest sequence is the head) and then the
+ * headers of the head sector alone, so boot reads a few KB however big the
+ * partition is.
+ *
+ * "DRAIN" streams every block newer than the last one a host confirmed:
+ * {"drain":{"start":seq,"pending":blocks}}, the stored frames, then
+ * {"drain":{"end":seq,"frames":n}}. It goes through the USB arena at
+ * whatever rate the port runs, after the live updates of each pass and as
+ * fast as the host reads. "DRAIN OK <seq>" then marks the blocks up to seq
+ * as delivered, kept in NVS. Without it the next DRAIN sends them again.
+ *
+ * Printer task only, apart from the flash_log_note_host(), request and
+ * confirm calls, which only set flags, and flash_log_get_stats().
+ */
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef RID_LOG_ENABLE
+#define RID_LOG_ENABLE 0
+#endif
+
+#ifndef RID_LOG_PARTITION
+#define RID_LOG_PARTITION "spiffs"     // Unused by this firmware in the stock partition tables
+#endif
+
+#ifndef RID_LOG_BLOCK
+#define RID_LOG_BLOCK 512              // Bytes per flash write
+#endif
+
+#ifndef RID_LOG_FLUSH_MS
+#define RID_LOG_FLUSH_MS 30000UL       // Longest a frame stays in RAM
+#endif
+
+#ifndef RID_LOG_HOST_TIMEOUT_MS
+#define RID_LOG_HOST_TIMEOUT_MS 30000UL  // No host command this long starts logging
+#endif
+
+#ifndef RID_LOG_DRAIN_RECORD
+#define RID_LOG_DRAIN_RECORD 256       // Longest USB record a drained block is cut into
+#endif
+
+#ifndef RID_LOG_DRAIN_SKIP
+#define RID_LOG_DRAIN_SKIP 64          // Block headers read per printer pass while draining
+#endif
+
+static_assert(4096 % RID_LOG_BLOCK == 0 && RID_LOG_BLOCK >= 256, "log blocks must tile a sector");
+
+struct flash_log_stats {
+  uint32_t sectors;                   // 0 without the partition
+  uint32_t frames;                    // Frames logged since boot
+  uint32_t blocks;                    // Blocks written since boot
+  uint32_t erases;
+  uint32_t failed;                    // Flash writes that returned an error
+  uint32_t pending;                   // Blocks not confirmed by a host (an upper bound after a lap)
+  uint8_t  active;                    // Logging now
+};
+
+// Finds the partition and the ring's head, and loads the confirmed sequence.
+// Call once from setup() after nvs_flash_init().
+void flash_log_begin();
+
+// A host command arrived.
+void flash_log_note_host();
+
+// True while deltas should be logged: enabled and no host heard lately.
+bool flash_log_active();
+
+// Appends one sealed frame to the RAM block, writing it out once full.
+void flash_log_append(const uint8_t *frame, size_t len);
+
+// Writes an old partial block and moves a drain along as far as the USB
+// arena allows. Returns the ms until it needs another call, 0 for none.
+uint32_t flash_log_service();
+
+// Host commands "DRAIN" and "DRAIN OK <seq>".
+void flash_log_request_drain();
+void flash_log_confirm(uint32_t seq);
+
+flash_log_stats flash_log_get_stats();
+
+#endif // FLASH_LOG_H
@@ -0,0 +1,110 @@
+/*
+ * Single-producer/single-consumer ring of raw Remote ID frames.
+ *
+ * The Wi-Fi promiscuous callback is the only producer and the decode task is
+ * the only consumer, so no lock is needed: each side owns one index and
+ * publishes it with release ordering. Slots are preallocated so the driver
+ * context never touches the heap.
+ */
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#ifndef FRAME_RING_SLOTS
+#define FRAME_RING_SLOTS 32     // Must be a power of two
+#endif
+
+#ifndef FRAME_RING_MAX_LEN
+#define FRAME_RING_MAX_LEN 320  // Largest NAN action frame carrying a full message pack, plus FCS
+#endif
+
+static_assert((FRAME_RING_SLOTS & (FRAME_RING_SLOTS - 1)) == 0, "FRAME_RING_SLOTS must be a power of two");
+
+enum frame_kind : uint8_t {
+  FRAME_NAN_ACTION = 0,   // data holds the whole 802.11 frame
+  FRAME_BEACON     = 1,   // data holds only the message pack from the vendor IE
+  FRAME_ESPNOW     = 2,   // data holds a batch from another node (espnow_link.h)
+};
+
+struct raw_frame {
+  uint8_t  kind;
+  int8_t   rssi;
+  uint8_t  channel;
+  uint8_t  reserved;
+  uint16_t len;
+  uint8_t  mac[6];
+  uint32_t rx_timestamp;  // rx_ctrl.timestamp, microseconds
+  uint32_t captured_us;   // esp_timer_get_time() in the callback
+  uint8_t  data[FRAME_RING_MAX_LEN];
+};
+
+struct frame_ring_stats {
+  uint32_t pushed;
+  uint32_t popped;
+  uint32_t dropped_full;      // Ring had no free slot
+  uint32_t dropped_oversize;  // Frame larger than FRAME_RING_MAX_LEN
+  uint32_t high_water;        // Deepest fill level observed by the producer
+};
+
+class FrameRing {
+public:
+  // Producer: returns a free slot or nullptr (counted as a drop) when full.
+  raw_frame *reserve() {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint32_t used = head - tail_.load(std::memory_order_acquire);
+    if (used >= FRAME_RING_SLOTS) {
+      dropped_full_++;
+      return nullptr;
+    }
+    if (used + 1 > high_water_) high_water_ = used + 1;
+    return &slots_[head & (FRAME_RING_SLOTS - 1)];
+  }
+
+  // Producer: publishes the slot returned by the last reserve().
+  void commit() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    pushed_++;
+  }
+
+  void drop_oversize() { dropped_oversize_++; }
+
+  // Consumer: oldest unread frame or nullptr when empty.
+  const raw_frame *peek() const {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return nullptr;
+    return &slots_[tail & (FRAME_RING_SLOTS - 1)];
+  }
+
+  // Consumer: hands the slot returned by peek() back to the producer.
+  void release() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    popped_++;
+  }
+
+  frame_ring_stats stats() const {
+    frame_ring_stats s;
+    s.pushed = pushed_;
+    s.popped = popped_;
+    s.dropped_full = dropped_full_;
+    s.dropped_oversize = dropped_oversize_;
+    s.high_water = high_water_;
+    return s;
+  }
+
+private:
+  raw_frame slots_[FRAME_RING_SLOTS];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  // Each counter has exactly one writer, so plain volatile words suffice.
+  volatile uint32_t pushed_ = 0;
+  volatile uint32_t popped_ = 0;
+  volatile uint32_t dropped_full_ = 0;
+  volatile uint32_t dropped_oversize_ = 0;
+  volatile uint32_t high_water_ = 0;
+};
+
+#endif // FRAME_RING_H
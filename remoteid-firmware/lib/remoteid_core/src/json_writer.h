@@ -0,0 +1,244 @@
+/*
+ * JSON and text lines for detections without printf. Coordinates are written
+ * from the 1e-7 degree integers the decoder keeps, with six decimals like
+ * the former "%.6f", and integers by a small itoa, so newlib's float printf
+ * is never reached on the output path. Nothing here touches the SDK; the
+ * native benchmark (test/test_native_json) builds it on the host.
+ *
+ * JsonWriter appends into a caller's buffer and stops at the end of it;
+ * ok() tells whether everything fit. uav_json() writes one detection line
+ * with the groups in `groups`, compact (what the mappers read) or with
+ * every decoded field. uav_auth_json() writes a reassembled signature.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "uav_auth.h"
+#include "uav_record.h"
+
+class JsonWriter {
+public:
+  JsonWriter(char *buf, size_t size) : buf_(buf), size_(size), len_(0), full_(false) {}
+
+  void raw(const char *s, size_t n) {
+    if (!room(n)) return;
+    memcpy(buf_ + len_, s, n);
+    len_ += n;
+  }
+
+  // String literals, with their length known at compile time
+  template <size_t N> void lit(const char (&s)[N]) { raw(s, N - 1); }
+
+  void ch(char c) {
+    if (room(1)) buf_[len_++] = c;
+  }
+
+  void u32(uint32_t v) {
+    char tmp[10];
+    char *p = tmp + sizeof(tmp);
+    do {
+      *--p = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    raw(p, tmp + sizeof(tmp) - p);
+  }
+
+  void u64(uint64_t v) {
+    if (v <= UINT32_MAX) {
+      u32((uint32_t)v);
+      return;
+    }
+    char tmp[20];
+    char *p = tmp + sizeof(tmp);
+    do {
+      *--p = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    raw(p, tmp + sizeof(tmp) - p);
+  }
+
+  void i32(int32_t v) {
+    if (v < 0) {
+      ch('-');
+      u32(0u - (uint32_t)v);
+    } else {
+      u32((uint32_t)v);
+    }
+  }
+
+  // Degrees from 1e-7 units, rounded half away from zero to six decimals
+  void degrees(int32_t e7) {
+    uint32_t mag = e7 < 0 ? 0u - (uint32_t)e7 : (uint32_t)e7;
+    mag = (mag + 5) / 10;
+    if (e7 < 0 && mag) ch('-');
+    u32(mag / 1000000);
+    char frac[7] = {'.'};
+    uint32_t f = mag % 1000000;
+    for (int i = 6; i > 0; i--, f /= 10) frac[i] = (char)('0' + f % 10);
+    raw(frac, sizeof(frac));
+  }
+
+  void mac(const uint8_t *mac) {
+    static const char hex[] = "0123456789abcdef";
+    char s[17];
+    for (int i = 0; i < 6; i++) {
+      s[i * 3] = hex[mac[i] >> 4];
+      s[i * 3 + 1] = hex[mac[i] & 0xf];
+      if (i < 5) s[i * 3 + 2] = ':';
+    }
+    raw(s, sizeof(s));
+  }
+
+  // Quoted, with characters that would break a JSON string replaced
+  void str(const char *s, size_t max) {
+    ch('"');
+    for (size_t i = 0; i < max && s[i]; i++) {
+      char c = s[i];
+      ch((c < 0x20 || c > 0x7e || c == '"' || c == '\\') ? '_' : c);
+    }
+    ch('"');
+  }
+
+  // Quoted standard base64 with padding
+  void base64(const uint8_t *data, size_t n) {
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    ch('"');
+    for (size_t i = 0; i < n; i += 3) {
+      uint32_t v = (uint32_t)data[i] << 16;
+      if (i + 1 < n) v |= (uint32_t)data[i + 1] << 8;
+      if (i + 2 < n) v |= data[i + 2];
+      char q[4] = {digits[v >> 18], digits[(v >> 12) & 63],
+                   i + 1 < n ? digits[(v >> 6) & 63] : '=', i + 2 < n ? digits[v & 63] : '='};
+      raw(q, sizeof(q));
+    }
+    ch('"');
+  }
+
+  bool ok() const { return !full_; }
+  size_t length() const { return len_; }
+
+private:
+  bool room(size_t n) {
+    if (full_ || n > size_ - len_) {
+      full_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  char *buf_;
+  size_t size_;
+  size_t len_;
+  bool full_;
+};
+
+// Writes one detection line without the newline. mac and rssi are always
+// present, and rx_us (time_sync.h) once set; the other fields only for the
+// message groups in groups. Returns the length, or 0 if the line does not
+// fit in size.
+static inline size_t uav_json(char *buf, size_t size, const uav_print *uav, uint8_t groups, bool full) {
+  JsonWriter w(buf, size);
+  w.lit("{\"mac\":\"");
+  w.mac(uav->mac);
+  w.lit("\",\"rssi\":");
+  w.i32(uav->rssi);
+  if (uav->rx_time_us > 0) {
+    w.lit(",\"rx_us\":");
+    w.u64((uint64_t)uav->rx_time_us);
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_LOCATION)) {
+    w.lit(",\"drone_lat\":");
+    w.degrees(uav->lat_e7);
+    w.lit(",\"drone_long\":");
+    w.degrees(uav->long_e7);
+    w.lit(",\"drone_altitude\":");
+    w.i32(uav->altitude_msl);
+    if (full) {
+      w.lit(",\"height_agl\":");
+      w.i32(uav->height_agl);
+      w.lit(",\"speed\":");
+      w.i32(uav->speed);
+      w.lit(",\"speed_vertical\":");
+      w.i32(uav->speed_vertical);
+      w.lit(",\"heading\":");
+      w.i32(uav->heading);
+      w.lit(",\"status\":");
+      w.u32(uav->status);
+    }
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_SYSTEM)) {
+    w.lit(",\"pilot_lat\":");
+    w.degrees(uav->base_lat_e7);
+    w.lit(",\"pilot_long\":");
+    w.degrees(uav->base_long_e7);
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_BASIC_ID)) {
+    w.lit(",\"basic_id\":");
+    w.str(uav->uav_id, sizeof(uav->uav_id));
+    w.lit(",\"ua_type\":");
+    w.u32(uav->ua_type);
+    if (full) {
+      w.lit(",\"id_type\":");
+      w.u32(uav->id_type);
+    }
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_OPERATOR_ID)) {
+    w.lit(",\"operator_id\":");
+    w.str(uav->op_id, sizeof(uav->op_id));
+    if (full) {
+      w.lit(",\"operator_id_type\":");
+      w.u32(uav->operator_id_type);
+    }
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_SELF_ID)) {
+    w.lit(",\"description\":");
+    w.str(uav->cold.description, sizeof(uav->cold.description));
+    if (full) {
+      w.lit(",\"desc_type\":");
+      w.u32(uav->cold.desc_type);
+    }
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_AUTH)) {
+    w.lit(",\"auth_type\":");
+    w.u32(uav->cold.auth_type);
+    w.lit(",\"auth_last_page\":");
+    w.u32(uav->cold.auth_last_page);
+    w.lit(",\"auth_pages\":");
+    w.u32(uav->cold.auth_pages);
+    if (full) {
+      w.lit(",\"auth_length\":");
+      w.u32(uav->cold.auth_length);
+      w.lit(",\"auth_timestamp\":");
+      w.u32(uav->cold.auth_timestamp);
+    }
+  }
+  w.ch('}');
+  return w.ok() ? w.length() : 0;
+}
+
+// Writes one reassembled Authentication blob as
+// {"mac":..,"auth_data":{"type":..,"last_page":..,"timestamp":..,"length":..,"data":"<base64>"}}
+// without the newline. Returns the length, or 0 if it does not fit in size.
+static inline size_t uav_auth_json(char *buf, size_t size, const uav_auth_blob *auth) {
+  JsonWriter w(buf, size);
+  w.lit("{\"mac\":\"");
+  w.mac(auth->mac);
+  w.lit("\",\"auth_data\":{\"type\":");
+  w.u32(auth->type);
+  w.lit(",\"last_page\":");
+  w.u32(auth->last_page);
+  w.lit(",\"timestamp\":");
+  w.u32(auth->timestamp);
+  w.lit(",\"length\":");
+  w.u32(auth->length);
+  w.lit(",\"data\":");
+  w.base64(auth->data, auth->length);
+  w.lit("}}");
+  return w.ok() ? w.length() : 0;
+}
+
+#endif // JSON_WRITER_H
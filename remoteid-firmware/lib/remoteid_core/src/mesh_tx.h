@@ -0,0 +1,203 @@
+/*
+ * Transmit scheduler for the low-bandwidth mesh link on Serial1.
+ *
+ * Detection code submits the latest lines for a drone and returns at once;
+ * a newer submission replaces whatever that drone still had pending. The
+ * loop that owns Serial1 asks for one line at a time with next_line(),
+ * which walks the drones round-robin so every drone gets its turn, and only
+ * hands out a line when the byte budget, the gap between radio packets and
+ * the drone's own minimum interval all allow it. Nothing here ever waits.
+ *
+ * submit() and next_line() may run on different tasks; both take the lock.
+ */
+
+#ifndef MESH_TX_H
+#define MESH_TX_H
+
+#include <stdint.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+
+#ifndef MESH_TX_SLOTS
+#define MESH_TX_SLOTS 16                  // Drones with lines waiting at once
+#endif
+
+#ifndef MESH_TX_LINES
+#define MESH_TX_LINES 2                   // Lines per drone update (drone + pilot)
+#endif
+
+#ifndef MESH_TX_LINE_MAX
+#define MESH_TX_LINE_MAX 128
+#endif
+
+#ifndef MESH_TX_BYTES_PER_SEC
+#define MESH_TX_BYTES_PER_SEC 40          // Long-run share of the mesh channel
+#endif
+
+#ifndef MESH_TX_BURST_BYTES
+#define MESH_TX_BURST_BYTES 256           // Budget that may build up while idle
+#endif
+
+#ifndef MESH_TX_GAP_MS
+#define MESH_TX_GAP_MS 1000UL             // Between any two lines, one mesh packet each
+#endif
+
+#ifndef MESH_TX_DRONE_INTERVAL_MS
+#define MESH_TX_DRONE_INTERVAL_MS 5000UL  // Between two updates of the same drone
+#endif
+
+static_assert(MESH_TX_SLOTS <= 255, "round-robin index is 8 bits");
+static_assert(MESH_TX_LINE_MAX <= 256, "line lengths are 8 bits");
+
+struct mesh_tx_stats {
+  uint32_t submitted;
+  uint32_t replaced;      // Pending update overwritten by a newer one
+  uint32_t dropped_full;  // Every slot busy with another drone's pending lines
+  uint32_t sent_lines;
+  uint32_t sent_bytes;
+};
+
+class MeshTxScheduler {
+public:
+  MeshTxScheduler() {
+    memset(slots_, 0, sizeof(slots_));
+    memset(&stats_, 0, sizeof(stats_));
+    tokens_ = (uint32_t)MESH_TX_BURST_BYTES * 1000;
+    last_refill_ = 0;
+    last_line_ = 0;
+    sent_any_ = false;
+    rr_ = 0;
+  }
+
+  // Queues count lines (at most MESH_TX_LINES, each cut to MESH_TX_LINE_MAX)
+  // as the pending update for mac. Returns false if no slot was free.
+  bool submit(const uint8_t *mac, const char *const *lines, uint8_t count) {
+    if (count > MESH_TX_LINES) count = MESH_TX_LINES;
+    portENTER_CRITICAL(&mux_);
+    stats_.submitted++;
+    mesh_tx_slot *slot = find_slot(mac);
+    if (!slot) {
+      stats_.dropped_full++;
+      portEXIT_CRITICAL(&mux_);
+      return false;
+    }
+    if (pending(*slot)) stats_.replaced++;
+    // An update already part sent carries on from where it was with the new text
+    if (!pending(*slot) || slot->part >= count) slot->part = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      size_t n = strnlen(lines[i], MESH_TX_LINE_MAX - 1);
+      memcpy(slot->line[i], lines[i], n);
+      slot->line[i][n] = '\0';
+      slot->len[i] = (uint8_t)n;
+    }
+    slot->count = count;
+    portEXIT_CRITICAL(&mux_);
+    return true;
+  }
+
+  // Copies the next line to send into out (MESH_TX_LINE_MAX bytes) and
+  // returns its length, or 0 if nothing may go out yet. room is how many
+  // bytes the UART can take right now; a line is only handed out if it
+  // fits there with its line ending.
+  size_t next_line(uint32_t now, size_t room, char *out) {
+    size_t n = 0;
+    portENTER_CRITICAL(&mux_);
+    refill(now);
+    if (!sent_any_ || now - last_line_ >= MESH_TX_GAP_MS) {
+      mesh_tx_slot *slot = pick(now);
+      if (slot) {
+        uint8_t len = slot->len[slot->part];
+        uint32_t cost = (uint32_t)(len + 2) * 1000;
+        if (len + 2u <= room && tokens_ >= cost) {
+          memcpy(out, slot->line[slot->part], len + 1);
+          n = len;
+          tokens_ -= cost;
+          last_line_ = now;
+          sent_any_ = true;
+          stats_.sent_lines++;
+          stats_.sent_bytes += len + 2;
+          if (++slot->part >= slot->count) {
+            // Update complete; this drone waits its interval, the next one goes
+            slot->last_sent = now;
+            rr_ = (uint8_t)((slot - slots_ + 1) % MESH_TX_SLOTS);
+          }
+        }
+      }
+    }
+    portEXIT_CRITICAL(&mux_);
+    return n;
+  }
+
+  mesh_tx_stats stats() {
+    portENTER_CRITICAL(&mux_);
+    mesh_tx_stats s = stats_;
+    portEXIT_CRITICAL(&mux_);
+    return s;
+  }
+
+private:
+  struct mesh_tx_slot {
+    uint8_t  mac[6];
+    uint8_t  used;
+    uint8_t  count;      // Lines in the pending update
+    uint8_t  part;       // Next line to send; == count when nothing is pending
+    uint8_t  len[MESH_TX_LINES];
+    uint32_t last_sent;  // When this drone's last update finished
+    char     line[MESH_TX_LINES][MESH_TX_LINE_MAX];
+  };
+
+  bool pending(const mesh_tx_slot &s) const { return s.used && s.part < s.count; }
+
+  // Slot already holding mac, else a free one, else the one idle longest.
+  mesh_tx_slot *find_slot(const uint8_t *mac) {
+    mesh_tx_slot *spare = nullptr;
+    for (uint16_t i = 0; i < MESH_TX_SLOTS; i++) {
+      mesh_tx_slot &s = slots_[i];
+      if (s.used && memcmp(s.mac, mac, 6) == 0) return &s;
+      if (pending(s)) continue;
+      if (!spare || (spare->used && (!s.used || (int32_t)(s.last_sent - spare->last_sent) < 0)))
+        spare = &s;
+    }
+    if (spare) {
+      memcpy(spare->mac, mac, 6);
+      spare->used = 1;
+      spare->count = spare->part = 0;
+      spare->last_sent = 0;
+    }
+    return spare;
+  }
+
+  // Drone whose turn it is: the one mid-update, else the next in round-robin
+  // order that has lines pending and has waited out its interval.
+  mesh_tx_slot *pick(uint32_t now) {
+    for (uint16_t k = 0; k < MESH_TX_SLOTS; k++) {
+      mesh_tx_slot &s = slots_[(rr_ + k) % MESH_TX_SLOTS];
+      if (!pending(s)) continue;
+      if (s.part > 0) return &s;
+      if (s.last_sent == 0 || now - s.last_sent >= MESH_TX_DRONE_INTERVAL_MS) {
+        rr_ = (uint8_t)(&s - slots_);
+        return &s;
+      }
+    }
+    return nullptr;
+  }
+
+  void refill(uint32_t now) {
+    uint32_t elapsed = now - last_refill_;
+    last_refill_ = now;
+    uint64_t tokens = (uint64_t)tokens_ + (uint64_t)elapsed * MESH_TX_BYTES_PER_SEC;
+    uint64_t cap = (uint64_t)MESH_TX_BURST_BYTES * 1000;
+    tokens_ = (uint32_t)(tokens < cap ? tokens : cap);
+  }
+
+  mesh_tx_slot slots_[MESH_TX_SLOTS];
+  mesh_tx_stats stats_;
+  uint32_t tokens_;       // Byte budget in thousandths of a byte
+  uint32_t last_refill_;
+  uint32_t last_line_;
+  bool sent_any_;
+  uint8_t rr_;
+  portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif // MESH_TX_H
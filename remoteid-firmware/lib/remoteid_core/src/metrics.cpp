@@ -0,0 +1,135 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "ble_scan.h"
+#include "boot_time.h"
+#include "capture.h"
+#include "metrics.h"
+#include "output.h"
+#include "track.h"
+
+static const uint32_t LATENCY_BOUNDS_MS[RID_LATENCY_BUCKETS - 1] = RID_LATENCY_BOUNDS_MS;
+
+// Per source so each cell has one writer
+static volatile uint32_t frames[RID_SOURCE_COUNT];
+static volatile uint32_t failures[RID_SOURCE_COUNT][RID_FAIL_COUNT];
+static volatile uint32_t latency[RID_LATENCY_BUCKETS];
+static volatile uint32_t latencyMaxUs;  // Printer raises it, the report resets it; a race
+                                        // costs at most one interval's maximum
+
+// Totals as of the previous record; the record prints the differences.
+struct metrics_totals {
+  uint32_t frames[RID_SOURCE_COUNT];
+  uint32_t failures[RID_FAIL_COUNT];
+  uint32_t latency[RID_LATENCY_BUCKETS];
+  uint32_t ring_full;
+  uint32_t ring_oversize;
+  uint32_t ble_duplicates;
+  uint32_t mesh_replaced;
+  uint32_t mesh_dropped;
+  uint32_t evictions;
+};
+
+static metrics_totals last;
+static uint32_t lastReportUs = 0;
+
+void metrics_note_frame(rid_source source) {
+  frames[source]++;
+  boot_time_mark(BOOT_FIRST_RID);
+}
+
+uint32_t metrics_frames(rid_source source) {
+  return frames[source];
+}
+
+void metrics_note_failure(rid_source source, rid_decode_fail reason) {
+  failures[source][reason]++;
+}
+
+void metrics_note_latency(uint32_t us) {
+  uint32_t ms = us / 1000;
+  int b = 0;
+  while (b < RID_LATENCY_BUCKETS - 1 && ms >= LATENCY_BOUNDS_MS[b]) b++;
+  latency[b]++;
+  if (us > latencyMaxUs) latencyMaxUs = us;
+}
+
+static void take_totals(metrics_totals *t) {
+  for (int s = 0; s < RID_SOURCE_COUNT; s++) t->frames[s] = frames[s];
+  for (int r = 0; r < RID_FAIL_COUNT; r++) {
+    t->failures[r] = 0;
+    for (int s = 0; s < RID_SOURCE_COUNT; s++) t->failures[r] += failures[s][r];
+  }
+  for (int b = 0; b < RID_LATENCY_BUCKETS; b++) t->latency[b] = latency[b];
+  frame_ring_stats rs = frameRing.stats();
+  t->ring_full = rs.dropped_full;
+  t->ring_oversize = rs.dropped_oversize;
+  t->ble_duplicates = bleDuplicates;
+  mesh_tx_stats ms = meshTx.stats();
+  t->mesh_replaced = ms.replaced;
+  t->mesh_dropped = ms.dropped_full;
+  tracker.lock();
+  t->evictions = tracker.evictions();
+  tracker.unlock();
+}
+
+void metrics_report() {
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  uint32_t interval_ms = (now - lastReportUs) / 1000;
+  if (interval_ms == 0) interval_ms = 1;
+  lastReportUs = now;
+
+  metrics_totals t;
+  take_totals(&t);
+  uint32_t f[RID_SOURCE_COUNT], total = 0;
+  for (int s = 0; s < RID_SOURCE_COUNT; s++) {
+    f[s] = t.frames[s] - last.frames[s];
+    total += f[s];
+  }
+  uint32_t fps10 = (uint32_t)((uint64_t)total * 10000 / interval_ms);
+
+  frame_ring_stats rs = frameRing.stats();
+  tracker.lock();
+  unsigned tracked = tracker.count();
+  tracker.unlock();
+  uint32_t max_us = latencyMaxUs;
+  latencyMaxUs = 0;
+
+  char buf[768];
+  int n = snprintf(buf, sizeof(buf),
+                   "{\"stats\":{\"uptime_s\":%u,\"interval_ms\":%u,\"fps\":%u.%u,"
+                   "\"frames\":{\"nan\":%u,\"beacon\":%u,\"ble_legacy\":%u,\"ble_extended\":%u,\"espnow\":%u},"
+                   "\"failures\":{\"not_rid\":%u,\"truncated\":%u,\"malformed\":%u},"
+                   "\"latency_bounds_ms\":[",
+                   (unsigned)(now / 1000000), (unsigned)interval_ms,
+                   (unsigned)(fps10 / 10), (unsigned)(fps10 % 10),
+                   (unsigned)f[RID_SOURCE_NAN], (unsigned)f[RID_SOURCE_BEACON],
+                   (unsigned)f[RID_SOURCE_BLE_LEGACY], (unsigned)f[RID_SOURCE_BLE_EXTENDED], (unsigned)f[RID_SOURCE_ESPNOW],
+                   (unsigned)(t.failures[RID_FAIL_NOT_RID] - last.failures[RID_FAIL_NOT_RID]),
+                   (unsigned)(t.failures[RID_FAIL_TRUNCATED] - last.failures[RID_FAIL_TRUNCATED]),
+                   (unsigned)(t.failures[RID_FAIL_MALFORMED] - last.failures[RID_FAIL_MALFORMED]));
+  for (int b = 0; b < RID_LATENCY_BUCKETS - 1 && n < (int)sizeof(buf); b++) {
+    n += snprintf(buf + n, sizeof(buf) - n, "%s%u", b ? "," : "", (unsigned)LATENCY_BOUNDS_MS[b]);
+  }
+  if (n < (int)sizeof(buf)) n += snprintf(buf + n, sizeof(buf) - n, "],\"latency\":[");
+  for (int b = 0; b < RID_LATENCY_BUCKETS && n < (int)sizeof(buf); b++) {
+    n += snprintf(buf + n, sizeof(buf) - n, "%s%u", b ? "," : "", (unsigned)(t.latency[b] - last.latency[b]));
+  }
+  if (n < (int)sizeof(buf)) {
+    snprintf(buf + n, sizeof(buf) - n,
+             "],\"latency_max_ms\":%u,"
+             "\"ring_depth\":%u,\"ring_high_water\":%u,\"ring_full_drops\":%u,\"ring_oversize_drops\":%u,"
+             "\"ble_duplicates\":%u,\"mesh_replaced\":%u,\"mesh_dropped\":%u,"
+             "\"tracked\":%u,\"evictions\":%u}}",
+             (unsigned)(max_us / 1000),
+             (unsigned)(rs.pushed - rs.popped), (unsigned)rs.high_water,
+             (unsigned)(t.ring_full - last.ring_full), (unsigned)(t.ring_oversize - last.ring_oversize),
+             (unsigned)(t.ble_duplicates - last.ble_duplicates),
+             (unsigned)(t.mesh_replaced - last.mesh_replaced), (unsigned)(t.mesh_dropped - last.mesh_dropped),
+             tracked, (unsigned)(t.evictions - last.evictions));
+  }
+  last = t;
+  // Newline in the same driver write rather than println's second one
+  size_t len = strlen(buf);
+  buf[len++] = '\n';
+  Serial.write((const uint8_t *)buf, len);
+}
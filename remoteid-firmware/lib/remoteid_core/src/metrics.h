@@ -0,0 +1,62 @@
+/*
+ * Runtime metrics record. Where the heartbeat gives totals since boot, the
+ * stats line covers the interval since the previous one, so a host can tell
+ * an RF-limited node (few frames) from a CPU-limited one (ring drops, long
+ * decode queue) or a serial-limited one (long capture-to-output latency).
+ *
+ *   frames     Remote ID frames decoded per source (NAN, beacon, BLE legacy,
+ *              BLE extended, detections relayed over ESP-NOW), and fps over
+ *              all of them
+ *   failures   candidates that did not decode: not_rid (another NAN service),
+ *              truncated, malformed (bad message pack or message)
+ *   latency    capture to the line handed to Serial, as a histogram over
+ *              RID_LATENCY_BOUNDS_MS plus the maximum
+ *   queues     ring depth and high-water mark, ring, mesh and tracker drops
+ *
+ * The record is printed every RID_STATS_INTERVAL_MS and whenever a host
+ * sends "STATS". Every counter has a single writer (the decode task, the BLE
+ * host task or the printer) and the report only reads them.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+#ifndef RID_STATS_INTERVAL_MS
+#define RID_STATS_INTERVAL_MS 10000UL
+#endif
+
+enum rid_source : uint8_t {
+  RID_SOURCE_NAN,
+  RID_SOURCE_BEACON,
+  RID_SOURCE_BLE_LEGACY,
+  RID_SOURCE_BLE_EXTENDED,
+  RID_SOURCE_ESPNOW,              // Detections relayed by other nodes (collector)
+  RID_SOURCE_COUNT
+};
+
+enum rid_decode_fail : uint8_t {
+  RID_FAIL_NOT_RID,
+  RID_FAIL_TRUNCATED,
+  RID_FAIL_MALFORMED,
+  RID_FAIL_COUNT
+};
+
+// Upper bounds of the latency buckets; one more bucket holds the rest.
+#define RID_LATENCY_BOUNDS_MS {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000}
+#define RID_LATENCY_BUCKETS 11
+
+void metrics_note_frame(rid_source source);
+
+// Frames decoded from source since boot.
+uint32_t metrics_frames(rid_source source);
+void metrics_note_failure(rid_source source, rid_decode_fail reason);
+
+// Printer only: time from capture to the drone's line going out.
+void metrics_note_latency(uint32_t us);
+
+// Prints the stats record on USB Serial. Call from one task only.
+void metrics_report();
+
+#endif // METRICS_H
@@ -0,0 +1,337 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "ble_scan.h"
+#include "boot_time.h"
+#include "capture.h"
+#include "coex.h"
+#include "detection_frame.h"
+#include "espnow_link.h"
+#include "flash_log.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "output.h"
+#include "output_format.h"
+#include "rid_config.h"
+#include "task_stats.h"
+#include "time_sync.h"
+#include "track.h"
+#include "uav_auth.h"
+#include "usb_tx.h"
+
+MeshTxScheduler meshTx;
+
+static uint32_t heapBaseline = 0;
+static uint32_t meshSkipped = 0;  // Updates the track found close enough to the last mesh line
+
+// Queues one JSON line for USB Serial. mac and rssi are always present; the
+// other fields only for the message groups flagged in UAV->dirty.
+void send_json_fast(const uav_print *UAV) {
+  char *json_msg = usb_tx_reserve();
+  if (!json_msg) return;
+  // Room for the newline
+  size_t n = uav_json(json_msg, RID_USB_TX_RECORD_MAX - 1, UAV, UAV->dirty, outputFormat == OUTPUT_JSON_FULL);
+  if (!n) return;
+  json_msg[n++] = '\n';
+  usb_tx_commit(n, UAV->pending_since_us);
+}
+
+// Adds the sections of the groups in UAV->dirty and, for USB, the RX time;
+// ext adds the fields only a collector needs instead.
+static void fill_frame(DetectionFrame &frame, const uav_print *UAV, bool ext) {
+  if (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_BASIC_ID)) frame.basic_id(UAV->ua_type, UAV->uav_id);
+  if (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_LOCATION)) frame.location(UAV->lat_e7, UAV->long_e7, UAV->altitude_msl);
+  if (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_AUTH)) frame.auth(UAV->cold.auth_type, UAV->cold.auth_last_page, UAV->cold.auth_pages);
+  if (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_SELF_ID)) frame.self_id(UAV->cold.description);
+  if (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_SYSTEM)) frame.system(UAV->base_lat_e7, UAV->base_long_e7);
+  if (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_OPERATOR_ID)) frame.operator_id(UAV->op_id);
+  if (!ext) {
+    if (UAV->rx_time_us > 0) frame.rx_time(UAV->rx_time_us);
+    return;
+  }
+  if (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_LOCATION)) {
+    frame.location_ext(UAV->height_agl, UAV->heading, UAV->speed, UAV->speed_vertical, UAV->status);
+  }
+  const uint8_t typed = UAV_GROUP_BIT(UAV_GROUP_BASIC_ID) | UAV_GROUP_BIT(UAV_GROUP_SELF_ID) |
+                        UAV_GROUP_BIT(UAV_GROUP_OPERATOR_ID);
+  if (UAV->dirty & typed) {
+    frame.types(UAV->id_type, UAV->operator_id_type,
+                (UAV->dirty & UAV_GROUP_BIT(UAV_GROUP_SELF_ID)) ? UAV->cold.desc_type : 0);
+  }
+}
+
+// Queues the same delta as send_json_fast as one binary DetectionFrame.
+void send_binary_fast(const uav_print *UAV) {
+  char *out = usb_tx_reserve();
+  if (!out) return;
+  DetectionFrame frame(UAV->mac, UAV->rssi);
+  fill_frame(frame, UAV, false);
+  size_t len = frame.finish();
+  memcpy(out, frame.data(), len);
+  usb_tx_commit(len, UAV->pending_since_us);
+}
+
+// Batches the same delta, with the extra fields, for the collector.
+void send_espnow(const uav_print *UAV) {
+  DetectionFrame frame(UAV->mac, UAV->rssi);
+  fill_frame(frame, UAV, true);
+  size_t len = frame.finish();
+  espnow_submit(frame.data(), len);
+}
+
+// Logs the delta with every field and its RX time, for a later DRAIN.
+static void log_delta(const uav_print *UAV) {
+  DetectionFrame frame(UAV->mac, UAV->rssi, DETECTION_FRAME_STORED);
+  fill_frame(frame, UAV, true);
+  if (UAV->rx_time_us > 0) frame.rx_time(UAV->rx_time_us);
+  size_t len = frame.finish();
+  flash_log_append(frame.data(), len);
+}
+
+// Queues a reassembled signature as a JSON line, in either output format;
+// binary frames share the port with lines and the blob is too long for one.
+void send_auth_json(const uav_auth_blob *auth) {
+  char *json_msg = usb_tx_reserve();
+  if (!json_msg) return;
+  size_t n = uav_auth_json(json_msg, RID_USB_TX_RECORD_MAX - 1, auth);
+  if (!n) return;
+  json_msg[n++] = '\n';
+  usb_tx_commit(n, auth->captured_us);
+}
+
+void mesh_tx_poll() {
+  char line[MESH_TX_LINE_MAX];
+  if (meshTx.next_line(millis(), Serial1.availableForWrite(), line)) {
+    Serial1.println(line);
+  }
+}
+
+#if RID_NODE_MODE
+// Queues the two mesh JSON messages for this drone: MAC with the track's
+// drone position, then remote ID with pilot position. mesh_tx_poll() sends them when the
+// drone's turn and the budget allow.
+bool print_compact_message(const uav_print *UAV) {
+  char json_drone[MESH_TX_LINE_MAX];
+  JsonWriter drone(json_drone, sizeof(json_drone) - 1);
+  drone.lit("{\"mac\":\"");
+  drone.mac(UAV->mac);
+  drone.lit("\",\"drone_lat\":");
+  drone.degrees(UAV->mesh_lat_e7);
+  drone.lit(",\"drone_long\":");
+  drone.degrees(UAV->mesh_lon_e7);
+  drone.ch('}');
+  json_drone[drone.length()] = '\0';
+
+  char json_pilot[MESH_TX_LINE_MAX];
+  JsonWriter pilot(json_pilot, sizeof(json_pilot) - 1);
+  pilot.lit("{\"remote_id\":");
+  pilot.str(UAV->uav_id, sizeof(UAV->uav_id));
+  pilot.lit(",\"pilot_lat\":");
+  pilot.degrees(UAV->base_lat_e7);
+  pilot.lit(",\"pilot_long\":");
+  pilot.degrees(UAV->base_long_e7);
+  pilot.ch('}');
+  json_pilot[pilot.length()] = '\0';
+
+  const char *lines[2] = { json_drone, json_pilot };
+  return meshTx.submit(UAV->mac, lines, 2);
+}
+#else
+// Queues the mesh update for this drone: the track's position and, once
+// known, the pilot's. mesh_tx_poll() sends it when the drone's turn and the budget allow.
+bool print_compact_message(const uav_print *UAV) {
+  char mesh_msg[MESH_TX_LINE_MAX];
+  JsonWriter drone(mesh_msg, sizeof(mesh_msg) - 1);
+  drone.lit("Drone: ");
+  drone.mac(UAV->mac);
+  drone.lit(" RSSI:");
+  drone.i32(UAV->rssi);
+  if (UAV->mesh_lat_e7 != 0 && UAV->mesh_lon_e7 != 0) {
+    drone.lit(" https://maps.google.com/?q=");
+    drone.degrees(UAV->mesh_lat_e7);
+    drone.ch(',');
+    drone.degrees(UAV->mesh_lon_e7);
+  }
+  mesh_msg[drone.length()] = '\0';
+  const char *lines[2] = { mesh_msg, NULL };
+  uint8_t count = 1;
+  
+  char pilot_msg[MESH_TX_LINE_MAX];
+  if (UAV->base_lat_e7 != 0 && UAV->base_long_e7 != 0) {
+    JsonWriter pilot(pilot_msg, sizeof(pilot_msg) - 1);
+    pilot.lit("Pilot: https://maps.google.com/?q=");
+    pilot.degrees(UAV->base_lat_e7);
+    pilot.ch(',');
+    pilot.degrees(UAV->base_long_e7);
+    pilot_msg[pilot.length()] = '\0';
+    lines[count++] = pilot_msg;
+  }
+  return meshTx.submit(UAV->mac, lines, count);
+}
+#endif
+
+// Sleeps until a drone is flagged, then prints the latest state of every
+// flagged drone with the groups that changed since its last line. Records
+// are copied out under the tracker lock and printed after it is released,
+// and only as many as the USB arena has room for; the rest stay flagged.
+// While the flash log is active a full arena no longer holds drones back,
+// since the log takes every delta whether USB has room or not.
+static void printerTask(void *param) {
+  static uav_print batch[PRINT_BATCH];
+  static uav_auth_blob auth;
+  bool waiting = false;  // Arena bytes unsent or drones left flagged
+  uint32_t logMs = 0;    // When the flash log wants its next call, 0 for never
+  for (;;) {
+    TickType_t wait = waiting ? pdMS_TO_TICKS(RID_USB_TX_FLUSH_MS) : portMAX_DELAY;
+    if (logMs && (wait == portMAX_DELAY || pdMS_TO_TICKS(logMs) < wait)) wait = pdMS_TO_TICKS(logMs);
+    ulTaskNotifyTake(pdTRUE, wait);
+    {
+      TaskBusy busy(RID_TASK_OUTPUT);
+      bool stalled = false;
+      bool logging = flash_log_active();
+      uint16_t n, max;
+      usb_tx_flush(true);
+      do {
+        max = usb_tx_room();
+        if (max > PRINT_BATCH || logging) max = PRINT_BATCH;
+        if (max == 0) {
+          usb_tx_note_stall();
+          stalled = true;
+          break;
+        }
+        tracker.lock();
+        n = tracker.collect_flagged(batch, max, [](id_data &stored, uav_print &copy) {
+          uint32_t now = millis();
+          uav_snapshot(&stored, &copy, uav_claim_dirty(&stored, now));
+          copy.mesh_due = uav_track_mesh_due(&stored.track, stored.base_lat_e7, stored.base_long_e7, now,
+                                             &copy.mesh_lat_e7, &copy.mesh_lon_e7);
+          if (!copy.mesh_due) meshSkipped++;
+        });
+        tracker.unlock();
+        bool meshQueued = false;
+        for (uint16_t i = 0; i < n; i++) {
+          batch[i].rx_time_us = time_sync_us(batch[i].rx_us);
+          if (outputFormat == OUTPUT_BINARY) send_binary_fast(&batch[i]);
+          else send_json_fast(&batch[i]);
+          if (RID_ESPNOW == RID_ESPNOW_NODE) send_espnow(&batch[i]);
+          if (logging) log_delta(&batch[i]);
+          if (batch[i].mesh_due) {
+            batch[i].mesh_due = print_compact_message(&batch[i]);
+            meshQueued |= batch[i].mesh_due;
+          }
+        }
+        // Only what the mesh queue took counts as sent; the rest stays due
+        if (meshQueued) {
+          uint32_t now = millis();
+          tracker.lock();
+          for (uint16_t i = 0; i < n; i++) {
+            if (!batch[i].mesh_due) continue;
+            id_data *stored = tracker.find(batch[i].mac);
+            if (stored) {
+              uav_track_mesh_sent(&stored->track, batch[i].mesh_lat_e7, batch[i].mesh_lon_e7, batch[i].base_lat_e7,
+                                  batch[i].base_long_e7, now);
+            }
+          }
+          tracker.unlock();
+        }
+        usb_tx_flush(false);
+      } while (n == max);
+      // Signatures completed meanwhile, each once
+      while (!stalled && usb_tx_room() > 0) {
+        tracker.lock();
+        bool ready = uav_auth_take(&auth, millis());
+        tracker.unlock();
+        if (!ready) break;
+        send_auth_json(&auth);
+      }
+      // Drain after the live updates, in what room they left
+      logMs = flash_log_service();
+      waiting = usb_tx_flush(false) || stalled;
+    }
+    // Updates arriving meanwhile coalesce into one line per drone next tick
+    vTaskDelay(pdMS_TO_TICKS(PRINT_TICK_MS));
+  }
+}
+
+// Record sizes and what the drone tables take, once at boot
+static void print_record_sizes() {
+  Serial.printf("{\"records\":{\"hot\":%u,\"cold\":%u,\"tracked\":%u,\"print\":%u,"
+                "\"capacity\":%u,\"cold_slots\":%u,\"tracker_bytes\":%u,\"cold_bytes\":%u,"
+                "\"batch_bytes\":%u}}\n",
+                (unsigned)sizeof(uav_hot), (unsigned)sizeof(uav_cold), (unsigned)sizeof(id_data),
+                (unsigned)sizeof(uav_print), (unsigned)MAX_UAVS, (unsigned)RID_COLD_SLOTS,
+                (unsigned)sizeof(tracker), (unsigned)(RID_COLD_SLOTS * (sizeof(uav_cold) + 1)),
+                (unsigned)(PRINT_BATCH * sizeof(uav_print)));
+}
+
+void output_begin() {
+  print_record_sizes();
+  task_stats_create(RID_TASK_OUTPUT, printerTask, "PrinterTask", RID_OUTPUT_STACK, RID_OUTPUT_PRIO,
+                    RID_OUTPUT_CORE, &trackNotifyTask);
+}
+
+void output_heap_baseline() {
+  heapBaseline = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+// heap_min_free is the low-water mark since boot. Once every table is filled
+// it should stop moving; a heap_free drifting below heap_boot means a leak.
+void output_heartbeat() {
+  frame_ring_stats rs = frameRing.stats();
+  tracker.lock();
+  unsigned tracked = tracker.count();
+  unsigned evictions = tracker.evictions();
+  unsigned emitted = tracker.emitted();
+  unsigned coalesced = tracker.coalesced();
+  unsigned skipped = meshSkipped;
+  uav_cold_stats cs = uav_cold_get_stats();
+  uav_auth_stats as = uav_auth_get_stats();
+  tracker.unlock();
+  char channels[160];
+  channelScheduler.format_frames(channels, sizeof(channels));
+  mesh_tx_stats ms = meshTx.stats();
+  usb_tx_stats us = usb_tx_get_stats();
+  espnow_stats es = espnow_get_stats();
+  time_sync_state ts = time_sync_get();
+  flash_log_stats ls = flash_log_get_stats();
+  coex_stats cx = coex_get_stats();
+  Serial.printf("{\"heartbeat\":\"Device is active and running.\",\"wifi_seen\":%u,\"wifi_passed\":%u,"
+                "\"ble_seen\":%u,\"ble_passed\":%u,\"ble_duplicates\":%u,"
+                "\"frames\":%u,\"decoded\":%u,"
+                "\"ring_full_drops\":%u,\"ring_oversize_drops\":%u,\"ring_high_water\":%u,"
+                "\"tracked\":%u,\"evictions\":%u,\"emitted\":%u,\"coalesced\":%u,"
+                "\"cold_used\":%u,\"cold_full\":%u,"
+                "\"auth_completed\":%u,\"auth_expired\":%u,\"auth_evicted\":%u,"
+                "\"channel\":%u,\"channel_frames\":%s,"
+                "\"mesh_lines\":%u,\"mesh_replaced\":%u,\"mesh_dropped\":%u,\"mesh_skipped\":%u,"
+                "\"usb_bytes\":%u,\"usb_writes\":%u,\"usb_stalls\":%u,"
+                "\"espnow_frames\":%u,\"espnow_sent\":%u,\"espnow_failed\":%u,\"espnow_dropped\":%u,"
+                "\"espnow_late\":%u,\"espnow_received\":%u,"
+                "\"time_source\":\"%s\",\"pps_edges\":%u,"
+                "\"log_frames\":%u,\"log_blocks\":%u,\"log_pending\":%u,\"log_active\":%u,"
+                "\"coex_ble_percent\":%u,\"wifi_listen_ms\":%u,\"ble_listen_ms\":%u,\"coex_changes\":%u,"
+                "\"boot_capture_us\":%u,\"boot_ble_us\":%u,\"boot_setup_us\":%u,\"boot_first_rid_us\":%u,"
+                "\"heap_boot\":%u,\"heap_free\":%u,\"heap_min_free\":%u,\"heap_largest\":%u}\n",
+                (unsigned)captureSeen, (unsigned)capturePassed,
+                (unsigned)bleSeen, (unsigned)blePassed, (unsigned)bleDuplicates,
+                (unsigned)rs.pushed, (unsigned)captureDecoded, (unsigned)rs.dropped_full,
+                (unsigned)rs.dropped_oversize, (unsigned)rs.high_water,
+                tracked, evictions, emitted, coalesced, (unsigned)cs.used, (unsigned)cs.full,
+                (unsigned)as.completed, (unsigned)as.expired, (unsigned)as.evicted,
+                (unsigned)channelScheduler.current_channel(), channels,
+                (unsigned)ms.sent_lines, (unsigned)ms.replaced, (unsigned)ms.dropped_full, skipped,
+                (unsigned)us.bytes, (unsigned)us.writes, (unsigned)us.stalls,
+                (unsigned)es.frames, (unsigned)es.sent, (unsigned)es.failed, (unsigned)es.dropped,
+                (unsigned)es.late, (unsigned)es.received,
+                time_sync_source_name(ts.source), (unsigned)ts.pps_edges,
+                (unsigned)ls.frames, (unsigned)ls.blocks, (unsigned)ls.pending, (unsigned)ls.active,
+                (unsigned)cx.ble_percent, (unsigned)cx.wifi_listen_ms, (unsigned)cx.ble_listen_ms,
+                (unsigned)cx.changes,
+                (unsigned)boot_time_us(BOOT_CAPTURE), (unsigned)boot_time_us(BOOT_BLE),
+                (unsigned)boot_time_us(BOOT_SETUP), (unsigned)boot_time_us(BOOT_FIRST_RID),
+                (unsigned)heapBaseline,
+                (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT),
+                (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+                (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
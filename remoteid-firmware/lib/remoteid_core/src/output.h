@@ -0,0 +1,46 @@
+/*
+ * Output sinks. printerTask sleeps until track_uas() flags a drone, then
+ * queues the groups that changed for USB Serial (JSON lines or binary
+ * frames, see output_format.h, batched by usb_tx.h) and, when the drone's
+ * track (uav_track.h) says the far end would be off, its mesh update on meshTx.
+ * Signatures reassembled by uav_auth.h follow as one JSON line each. A node
+ * with RID_ESPNOW_NODE also batches every delta for its collector
+ * (espnow_link.h).
+ * mesh_tx_poll() is the only writer to Serial1.
+ *
+ * The mesh update is human-readable text, or with RID_NODE_MODE two short
+ * JSON lines a Meshtastic node can forward as they are.
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "mesh_tx.h"
+#include "uav_auth.h"
+#include "uav_record.h"
+
+#define PRINT_BATCH 8
+#define PRINT_TICK_MS 50          // Each drone is printed at most once per tick
+
+extern MeshTxScheduler meshTx;
+
+// Prints the record sizes, then starts printerTask on RID_OUTPUT_CORE at
+// RID_OUTPUT_PRIO and points track_uas() at it.
+void output_begin();
+
+// Hands queued mesh lines to Serial1 as the TX budget allows. Call from loop().
+void mesh_tx_poll();
+
+// Notes the free heap once setup() is done; the heartbeat reports against it.
+void output_heap_baseline();
+
+// Prints the JSON heartbeat with capture, tracker, mesh, ESP-NOW, clock and heap counters.
+void output_heartbeat();
+
+void send_json_fast(const uav_print *UAV);
+void send_binary_fast(const uav_print *UAV);
+void send_espnow(const uav_print *UAV);
+bool print_compact_message(const uav_print *UAV);
+void send_auth_json(const uav_auth_blob *auth);
+
+#endif // OUTPUT_H
@@ -0,0 +1,88 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include "flash_log.h"
+#include "metrics.h"
+#include "output_format.h"
+#include "rid_config.h"
+#include "time_sync.h"
+
+volatile uint8_t outputFormat = OUTPUT_FORMAT_DEFAULT;
+
+static uint32_t baudCurrent = RID_SERIAL_BAUD;
+static uint32_t baudDeadline = 0;  // millis() by which "BAUD OK" is due, 0 once settled
+
+static const uint32_t BAUD_RATES[] = {115200, 230400, 460800, 921600, 1500000, 2000000};
+
+static const char *format_name(uint8_t format) {
+  if (format == OUTPUT_BINARY) return "binary";
+  return format == OUTPUT_JSON_FULL ? "json_full" : "json";
+}
+
+static void set_format(uint8_t format) {
+  outputFormat = format;
+  Preferences prefs;
+  if (prefs.begin("remoteid", false)) {
+    prefs.putUChar("output", format);
+    prefs.end();
+  }
+  Serial.printf("{\"output\":\"%s\"}\n", format_name(format));
+}
+
+static void switch_baud(uint32_t baud) {
+  Serial.flush();  // The acknowledgement goes out at the old rate
+#if !ARDUINO_USB_CDC_ON_BOOT
+  Serial.updateBaudRate(baud);  // USB CDC has no line rate to change
+#endif
+  baudCurrent = baud;
+}
+
+static void request_baud(uint32_t baud) {
+  bool allowed = false;
+  for (uint32_t b : BAUD_RATES) allowed |= b == baud;
+  if (!allowed) {
+    Serial.printf("{\"baud\":%u,\"error\":\"unsupported\"}\n", (unsigned)baudCurrent);
+    return;
+  }
+  Serial.printf("{\"baud\":%u}\n", (unsigned)baud);
+  switch_baud(baud);
+  baudDeadline = baud == RID_SERIAL_BAUD ? 0 : (millis() + RID_BAUD_CONFIRM_MS) | 1;
+}
+
+void output_format_begin() {
+  Preferences prefs;
+  if (prefs.begin("remoteid", true)) {
+    outputFormat = prefs.getUChar("output", OUTPUT_FORMAT_DEFAULT);
+    prefs.end();
+  }
+  if (outputFormat > OUTPUT_JSON_FULL) outputFormat = OUTPUT_JSON;
+  Serial.printf("{\"output\":\"%s\"}\n", format_name(outputFormat));
+}
+
+void output_format_poll() {
+  static char line[32];
+  static uint8_t len = 0;
+  if (baudDeadline && (int32_t)(millis() - baudDeadline) >= 0) {
+    baudDeadline = 0;
+    switch_baud(RID_SERIAL_BAUD);
+    Serial.printf("{\"baud\":%u}\n", (unsigned)baudCurrent);
+  }
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (len < sizeof(line) - 1) line[len++] = c;
+      continue;
+    }
+    line[len] = '\0';
+    len = 0;
+    if (line[0]) flash_log_note_host();
+    if (strcasecmp(line, "OUTPUT BINARY") == 0) set_format(OUTPUT_BINARY);
+    else if (strcasecmp(line, "OUTPUT JSON") == 0) set_format(OUTPUT_JSON);
+    else if (strcasecmp(line, "OUTPUT JSON FULL") == 0) set_format(OUTPUT_JSON_FULL);
+    else if (strcasecmp(line, "STATS") == 0) metrics_report();
+    else if (strcasecmp(line, "BAUD OK") == 0) baudDeadline = 0;
+    else if (strncasecmp(line, "BAUD ", 5) == 0) request_baud(strtoul(line + 5, nullptr, 10));
+    else if (strncasecmp(line, "TIME ", 5) == 0) time_sync_set_host(strtoll(line + 5, nullptr, 10));
+    else if (strncasecmp(line, "DRAIN OK ", 9) == 0) flash_log_confirm(strtoul(line + 9, nullptr, 10));
+    else if (strcasecmp(line, "DRAIN") == 0) flash_log_request_drain();
+  }
+}
@@ -0,0 +1,48 @@
+/*
+ * Selects how detections go out on USB Serial: JSON lines (the default),
+ * JSON lines with every decoded field, or binary DetectionFrame records. The
+ * choice is kept in NVS so it survives a reboot; a host switches it by
+ * sending "OUTPUT JSON", "OUTPUT JSON FULL" or "OUTPUT BINARY".
+ * "STATS" asks for a metrics record (metrics.h) on the spot.
+ *
+ * "BAUD <rate>" raises the USB Serial rate for UART-bridged boards: the
+ * device acknowledges with {"baud":rate} at the old rate and switches. The
+ * host must then send "BAUD OK" at the new rate within RID_BAUD_CONFIRM_MS,
+ * or the device falls back to RID_SERIAL_BAUD so a host that missed the
+ * switch finds it again. On native USB CDC the rate is only acknowledged.
+ *
+ * "TIME <unix_us>" gives the node the host's clock (time_sync.h) and is
+ * answered with a {"time":{...}} record.
+ *
+ * "DRAIN" and "DRAIN OK <seq>" read back and release the flash backlog
+ * (flash_log.h). Any command counts as a host being there.
+ */
+
+#ifndef OUTPUT_FORMAT_H
+#define OUTPUT_FORMAT_H
+
+#include <stdint.h>
+
+#ifndef OUTPUT_FORMAT_DEFAULT
+#define OUTPUT_FORMAT_DEFAULT OUTPUT_JSON  // Used until a host picks one
+#endif
+
+#ifndef RID_BAUD_CONFIRM_MS
+#define RID_BAUD_CONFIRM_MS 2000UL
+#endif
+
+enum output_format : uint8_t {
+  OUTPUT_JSON   = 0,
+  OUTPUT_BINARY = 1,
+  OUTPUT_JSON_FULL = 2,  // Adds height, speeds, heading, status and ID types
+};
+
+extern volatile uint8_t outputFormat;
+
+// Loads the stored format. Call once from setup() after nvs_flash_init().
+void output_format_begin();
+
+// Reads host commands from USB Serial without blocking. Call from a loop.
+void output_format_poll();
+
+#endif // OUTPUT_FORMAT_H
@@ -0,0 +1,110 @@
+/*
+ * Build-time choices for one firmware image. Every environment in
+ * platformio.ini builds the same sources; the flags below pick the radios,
+ * the mesh message format, the UART pins and where the tasks run.
+ *
+ *   RID_ENABLE_BLE  1 scans Bluetooth Remote ID next to Wi-Fi
+ *   RID_NODE_MODE   1 sends JSON mesh lines and echoes the mesh radio's UART
+ *                   to USB, for boards wired to a Meshtastic node
+ *   RID_ESPNOW      1 batches detections to a collector over ESP-NOW, 2 is
+ *                   that collector (espnow_link.h)
+ *   RID_PPS_PIN     GPIO wired to a GPS PPS output, for detection timestamps
+ *                   aligned across nodes (time_sync.h)
+ *   RID_COEX_MODE   Wi-Fi / BLE airtime split on one radio: fixed or adaptive
+ *                   to where detections come from (coex_scheduler.h)
+ *   RID_LOG_ENABLE  1 keeps detections in the "spiffs" partition while no
+ *                   host is connected, for a later DRAIN (flash_log.h)
+ */
+
+#ifndef RID_CONFIG_H
+#define RID_CONFIG_H
+
+#include <sdkconfig.h>
+
+#ifndef RID_ENABLE_BLE
+#define RID_ENABLE_BLE 1
+#endif
+
+#ifndef RID_NODE_MODE
+#define RID_NODE_MODE 0
+#endif
+
+#ifndef RID_SERIAL_BAUD
+#define RID_SERIAL_BAUD 115200          // USB Serial at boot; a host may raise it
+#endif
+
+#ifndef RID_SERIAL1_BAUD
+#define RID_SERIAL1_BAUD 115200         // Mesh radio UART
+#endif
+
+#ifndef RID_SERIAL1_RX_PIN
+#define RID_SERIAL1_RX_PIN 6
+#endif
+
+#ifndef RID_SERIAL1_TX_PIN
+#define RID_SERIAL1_TX_PIN 5
+#endif
+
+#ifndef RID_BOOT_DELAY_MS
+#define RID_BOOT_DELAY_MS 0             // Mesh output held back after boot for the mesh radio to come up
+#endif
+
+#ifndef MAX_UAVS
+#define MAX_UAVS 256
+#endif
+
+#define UAV_TIMEOUT_MS 300000UL         // Forget drones not heard for 5 minutes
+
+// ODID message types decoded from each frame; the others are skipped in place.
+#ifndef RID_DECODE_TYPES
+#define RID_DECODE_TYPES ODID_LEAN_ALL
+#endif
+
+#define RID_WIFI_CORE 0                 // Where the Wi-Fi driver runs
+
+// Task layout. Decoding stays on the Wi-Fi core next to the driver callback
+// that fills the ring; printing and the UART echo take the other core on
+// dual-core chips, at the lowest priority. The Bluetooth host task (and the
+// tracker merge for BLE adverts inside it) is placed by the core's sdkconfig.
+// Every value can be overridden; task_stats_report() shows the CPU share and
+// unused stack of each task to check a layout on hardware.
+#ifndef RID_DECODE_CORE
+#define RID_DECODE_CORE RID_WIFI_CORE
+#endif
+#ifndef RID_DECODE_PRIO
+#define RID_DECODE_PRIO 2
+#endif
+#ifndef RID_DECODE_STACK
+#define RID_DECODE_STACK 8192
+#endif
+
+#ifndef RID_HOP_PRIO
+#define RID_HOP_PRIO 3                  // Above decoding so dwell times hold
+#endif
+#ifndef RID_HOP_STACK
+#define RID_HOP_STACK 2048
+#endif
+
+#ifndef RID_OUTPUT_CORE
+#if CONFIG_FREERTOS_UNICORE
+#define RID_OUTPUT_CORE 0
+#else
+#define RID_OUTPUT_CORE 1
+#endif
+#endif
+#ifndef RID_OUTPUT_PRIO
+#define RID_OUTPUT_PRIO 1
+#endif
+#ifndef RID_OUTPUT_STACK
+#define RID_OUTPUT_STACK 10000
+#endif
+
+#ifndef RID_BLE_INIT_STACK
+#define RID_BLE_INIT_STACK 8192         // One-shot task bringing up BLE during setup()
+#endif
+
+#ifndef RID_UART_STACK
+#define RID_UART_STACK 4096             // Node mode UART-to-USB echo
+#endif
+
+#endif // RID_CONFIG_H
@@ -0,0 +1,98 @@
+/*
+ * Remote ID candidate checks on raw frame and advert bytes, shared by the
+ * Wi-Fi promiscuous callback, the BLE GAP callback and the host benchmark
+ * (test/test_native_bench). Nothing here touches the SDK, so the same code
+ * is measured on the host as runs on the chip.
+ */
+
+#ifndef RID_PREFILTER_H
+#define RID_PREFILTER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "frame_ring.h"
+
+// First frame control byte of the management subtypes Remote ID uses.
+static const uint8_t FC_BEACON = 0x80;
+static const uint8_t FC_ACTION = 0xd0;
+
+// Vendor IE OUI and type as one little-endian word, with the bytes that must
+// match. ASTM F3411 fixes the type (0x0D); the Parrot OUI is matched on its
+// own as before.
+struct vendor_ie_match {
+  uint32_t value;
+  uint32_t mask;
+};
+static const vendor_ie_match RID_VENDOR_IES[] = {
+  { 0x0dbc0bfa, 0xffffffff },  // fa:0b:bc type 0x0d (ASTM F3411)
+  { 0x00e63a90, 0x00ffffff },  // 90:3a:e6
+};
+
+static inline uint32_t load_le32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));  // IEs sit at any offset; let the compiler pick the load
+  return v;
+}
+
+// Returns the message pack inside the first Remote ID vendor IE of a beacon,
+// or nullptr. end excludes the FCS; no byte at or past it is read.
+static inline const uint8_t *find_rid_vendor_ie(const uint8_t *payload, int end, int *pack_len) {
+  int offset = 36;  // 24 byte header, timestamp, interval, capabilities
+  while (offset + 2 <= end) {
+    int len = payload[offset + 1];
+    if (offset + 2 + len > end) break;
+    // OUI, type and message counter precede the pack
+    if (payload[offset] == 0xdd && len > 5) {
+      uint32_t word = load_le32(&payload[offset + 2]);
+      for (const vendor_ie_match &m : RID_VENDOR_IES) {
+        if ((word & m.mask) == m.value) {
+          *pack_len = len - 5;
+          return &payload[offset + 7];
+        }
+      }
+    }
+    offset += len + 2;
+  }
+  return nullptr;
+}
+
+// Returns the bytes to queue for a beacon or action frame of length bytes
+// (FCS included), or nullptr: the whole frame for a NAN action frame to the
+// Remote ID cluster address, the message pack for a beacon's Remote ID IE.
+static inline const uint8_t *rid_wifi_candidate(const uint8_t *payload, int length,
+                                                int *data_len, uint8_t *kind) {
+  static const uint8_t nan_dest[6] = {0x51, 0x6f, 0x9a, 0x01, 0x00, 0x00};
+  if (payload[0] == FC_ACTION) {
+    if (memcmp(nan_dest, &payload[4], 6) != 0) return nullptr;
+    *kind = FRAME_NAN_ACTION;
+    *data_len = length;
+    return payload;
+  }
+  *kind = FRAME_BEACON;
+  return find_rid_vendor_ie(payload, length - 4, data_len);
+}
+
+#define AD_TYPE_SERVICE_DATA 0x16
+#define ODID_APP_CODE        0x0D
+
+// Walks the AD structures of an advert for the Remote ID service data and
+// returns the message counter byte, followed by the message (or message
+// pack); nullptr when there is none.
+static inline const uint8_t *find_odid_service_data(const uint8_t *adv, int len, int *odid_len) {
+  int i = 0;
+  while (i + 1 < len) {
+    int ad_len = adv[i];
+    if (ad_len == 0 || i + 1 + ad_len > len) return nullptr;
+    const uint8_t *ad = &adv[i + 1];
+    // type, UUID 0xFFFA little endian, application code, counter
+    if (ad_len > 5 && ad[0] == AD_TYPE_SERVICE_DATA && ad[1] == 0xFA &&
+        ad[2] == 0xFF && ad[3] == ODID_APP_CODE) {
+      *odid_len = ad_len - 5;
+      return &ad[4];
+    }
+    i += 1 + ad_len;
+  }
+  return nullptr;
+}
+
+#endif // RID_PREFILTER_H
@@ -0,0 +1,73 @@
+#include "task_stats.h"
+
+#include <Arduino.h>
+
+struct task_stat {
+  const char *name;
+  TaskHandle_t handle;
+  int8_t core;
+  uint8_t prio;
+  uint32_t stack;               // 0 when created elsewhere
+  volatile uint32_t busy_us;
+  uint32_t reported_us;
+};
+
+static task_stat tasks[RID_TASK_COUNT];
+static uint32_t lastReportUs = 0;
+
+bool task_stats_create(rid_task id, TaskFunction_t fn, const char *name, uint32_t stack,
+                       UBaseType_t prio, BaseType_t core, TaskHandle_t *handle) {
+  TaskHandle_t h = nullptr;
+  if (xTaskCreatePinnedToCore(fn, name, stack, NULL, prio, &h, core) != pdPASS) return false;
+  tasks[id].name = name;
+  tasks[id].core = core;
+  tasks[id].prio = prio;
+  tasks[id].stack = stack;
+  tasks[id].handle = h;
+  if (handle) *handle = h;
+  return true;
+}
+
+void task_stats_adopt(rid_task id, const char *name, int core) {
+  TaskHandle_t h = xTaskGetHandle(name);
+  if (!h) return;
+  tasks[id].name = name;
+  tasks[id].core = core;
+  tasks[id].prio = uxTaskPriorityGet(h);
+  tasks[id].stack = 0;
+  tasks[id].handle = h;
+}
+
+void task_stats_add_busy(rid_task id, uint32_t us) {
+  tasks[id].busy_us += us;
+}
+
+void task_stats_report() {
+  uint32_t now = (uint32_t)esp_timer_get_time();
+  uint32_t interval = now - lastReportUs;
+  lastReportUs = now;
+  if (interval == 0) interval = 1;
+
+  char buf[768];
+  int n = snprintf(buf, sizeof(buf), "{\"tasks\":[");
+  bool first = true;
+  for (task_stat &t : tasks) {
+    if (!t.handle || n >= (int)sizeof(buf)) continue;
+    uint32_t busy = t.busy_us;
+    uint32_t permille = (uint32_t)((uint64_t)(busy - t.reported_us) * 1000 / interval);
+    t.reported_us = busy;
+    // ESP-IDF counts the high-water mark in bytes
+    n += snprintf(buf + n, sizeof(buf) - n,
+                  "%s{\"name\":\"%s\",\"core\":%d,\"prio\":%u,\"stack\":%u,\"stack_free\":%u,\"cpu_permille\":%u}",
+                  first ? "" : ",", t.name, t.core, (unsigned)t.prio, (unsigned)t.stack,
+                  (unsigned)uxTaskGetStackHighWaterMark(t.handle), (unsigned)permille);
+    first = false;
+  }
+  if (n < (int)sizeof(buf)) {
+    snprintf(buf + n, sizeof(buf) - n, "],\"interval_ms\":%u}", (unsigned)(interval / 1000));
+  }
+  // Newline in the same driver write rather than println's second one
+  size_t len = strlen(buf);
+  buf[len++] = '\n';
+  Serial.write((const uint8_t *)buf, len);
+}
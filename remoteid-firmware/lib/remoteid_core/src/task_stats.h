@@ -0,0 +1,52 @@
+/*
+ * CPU time and stack high-water marks of the firmware's tasks, to check the
+ * task layout in rid_config.h on real hardware. Each task brackets its work,
+ * not its waits, with a TaskBusy. task_stats_report() prints one JSON line
+ * with every task's core, priority, stack size, unused stack and the share
+ * of the interval since the previous report it spent busy (per mille).
+ * Busy time is wall time, so it includes preemption and blocking writes.
+ *
+ * Every busy counter has a single writer, its own task, so no lock is needed.
+ */
+
+#ifndef TASK_STATS_H
+#define TASK_STATS_H
+
+#include <stdint.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+enum rid_task {
+  RID_TASK_DECODE,
+  RID_TASK_HOP,
+  RID_TASK_OUTPUT,
+  RID_TASK_UART,
+  RID_TASK_BLE,                   // Bluetooth host task running the GAP callback
+  RID_TASK_LOOP,                  // Arduino loop()
+  RID_TASK_COUNT
+};
+
+// Creates a task pinned to core and registers it for the report.
+bool task_stats_create(rid_task id, TaskFunction_t fn, const char *name, uint32_t stack,
+                       UBaseType_t prio, BaseType_t core, TaskHandle_t *handle);
+
+// Registers a task created elsewhere, found by its FreeRTOS name; core is
+// -1 when unknown. Does nothing if no such task exists.
+void task_stats_adopt(rid_task id, const char *name, int core);
+
+void task_stats_add_busy(rid_task id, uint32_t us);
+
+class TaskBusy {
+public:
+  explicit TaskBusy(rid_task id) : id_(id), start_((uint32_t)esp_timer_get_time()) {}
+  ~TaskBusy() { task_stats_add_busy(id_, (uint32_t)esp_timer_get_time() - start_); }
+private:
+  rid_task id_;
+  uint32_t start_;
+};
+
+// Prints the task report on USB Serial. Call from one task only.
+void task_stats_report();
+
+#endif // TASK_STATS_H
@@ -0,0 +1,104 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include "time_sync.h"
+
+// Written by loop() (host command and PPS handling), read by the printer;
+// 64-bit values need the lock on 32-bit cores.
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static time_sync_state state;
+static bool hostSet = false;
+static uint32_t lastEdgeMs = 0;
+
+// Set by the interrupt, taken by time_sync_poll()
+static volatile int64_t edgeUs = 0;
+static volatile bool edgePending = false;
+
+static void IRAM_ATTR on_pps() {
+  edgeUs = esp_timer_get_time();
+  edgePending = true;
+}
+
+const char *time_sync_source_name(uint8_t source) {
+  if (source == TIME_PPS) return "pps";
+  return source == TIME_HOST ? "host" : "none";
+}
+
+void time_sync_report() {
+  time_sync_state s = time_sync_get();
+  Serial.printf("{\"time\":{\"source\":\"%s\",\"offset_us\":%lld,\"pps_edges\":%u,\"pps_step_us\":%d}}\n",
+                time_sync_source_name(s.source), (long long)s.offset_us, (unsigned)s.pps_edges,
+                (int)s.pps_step_us);
+}
+
+void time_sync_begin() {
+  if (RID_PPS_PIN < 0) return;
+  pinMode(RID_PPS_PIN, INPUT);
+  attachInterrupt(digitalPinToInterrupt(RID_PPS_PIN), on_pps, RISING);
+}
+
+void time_sync_set_host(int64_t unix_us) {
+  int64_t offset = unix_us - esp_timer_get_time();
+  portENTER_CRITICAL(&lock);
+  hostSet = true;
+  // PPS already holds the phase; the host only matters if it names another second
+  int64_t drift = offset - state.offset_us;
+  bool keep = state.source == TIME_PPS && drift > -500000 && drift < 500000;
+  if (!keep) {
+    state.source = TIME_HOST;
+    state.offset_us = offset;
+  }
+  portEXIT_CRITICAL(&lock);
+  time_sync_report();
+}
+
+void time_sync_poll() {
+  if (RID_PPS_PIN < 0) return;
+  uint32_t now = millis();
+  bool changed = false;
+  if (edgePending) {
+    portENTER_CRITICAL(&lock);
+    int64_t edge = edgeUs;
+    edgePending = false;
+    if (hostSet) {
+      // Nearest whole second to the edge on the clock we have, then that second exactly
+      int64_t unix_us = edge + state.offset_us;
+      int64_t second = (unix_us + 500000) / 1000000 * 1000000;
+      int64_t offset = second - edge;
+      state.pps_step_us = (int32_t)(offset - state.offset_us);
+      changed = state.source != TIME_PPS;
+      state.source = TIME_PPS;
+      state.offset_us = offset;
+      state.pps_edges++;
+      lastEdgeMs = now;
+    }
+    portEXIT_CRITICAL(&lock);
+  } else if (state.source == TIME_PPS && now - lastEdgeMs > RID_PPS_TIMEOUT_MS) {
+    // Lost the PPS signal: hold the last PPS offset, reported as host time
+    portENTER_CRITICAL(&lock);
+    state.source = TIME_HOST;
+    portEXIT_CRITICAL(&lock);
+    changed = true;
+  }
+  if (changed) time_sync_report();
+}
+
+int64_t time_sync_local_us(uint32_t stamp_us) {
+  int64_t now = esp_timer_get_time();
+  return now - (int64_t)(uint32_t)((uint32_t)now - stamp_us);
+}
+
+int64_t time_sync_us(uint32_t stamp_us) {
+  int64_t local = time_sync_local_us(stamp_us);
+  portENTER_CRITICAL(&lock);
+  int64_t offset = state.source == TIME_NONE ? 0 : state.offset_us;
+  portEXIT_CRITICAL(&lock);
+  return local + offset;
+}
+
+time_sync_state time_sync_get() {
+  portENTER_CRITICAL(&lock);
+  time_sync_state s = state;
+  portEXIT_CRITICAL(&lock);
+  return s;
+}
@@ -0,0 +1,73 @@
+/*
+ * One clock for detection timestamps across nodes, so a host can join the
+ * receptions of a single frame by several nodes.
+ *
+ * Every record carries the reception time of its newest frame on the
+ * esp_timer clock (uav_hot::rx_us): the driver's rx_ctrl.timestamp for
+ * Wi-Fi, mapped onto esp_timer by capture.cpp, and the GAP callback's entry
+ * for BLE, which Bluedroid does not timestamp any earlier. time_sync_us()
+ * turns it into microseconds since the Unix epoch once the node is synced,
+ * and leaves it as microseconds since boot before that; hosts tell the two
+ * apart by size.
+ *
+ *   host  "TIME <unix_us>" over USB Serial sets the offset, to within the
+ *         serial latency (well under a millisecond at 921600 baud). The
+ *         mapper sends it on connect and every minute.
+ *   pps   With RID_PPS_PIN wired to a GPS PPS output, each rising edge marks
+ *         a whole second. Once a host time is known, time_sync_poll() snaps
+ *         the offset to the edge, to within the interrupt latency. The host
+ *         time is then only used to pick the second.
+ *
+ * The state is reported as {"time":{...}} after every change of source and
+ * in the heartbeat.
+ */
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+
+#ifndef RID_PPS_PIN
+#define RID_PPS_PIN -1                // GPIO with the GPS PPS signal, -1 for none
+#endif
+
+#ifndef RID_PPS_TIMEOUT_MS
+#define RID_PPS_TIMEOUT_MS 3000UL     // Back to the host offset without an edge for this long
+#endif
+
+enum time_source : uint8_t {
+  TIME_NONE = 0,                      // Microseconds since boot
+  TIME_HOST,
+  TIME_PPS,
+};
+
+struct time_sync_state {
+  uint8_t  source;                    // time_source
+  int64_t  offset_us;                 // Unix time minus esp_timer time
+  uint32_t pps_edges;
+  int32_t  pps_step_us;               // Correction made by the last edge
+};
+
+// Attaches the PPS interrupt if RID_PPS_PIN is set.
+void time_sync_begin();
+
+// Applies a host time, in microseconds since the Unix epoch, as of now.
+void time_sync_set_host(int64_t unix_us);
+
+// Follows the PPS edges. Call from loop().
+void time_sync_poll();
+
+// The esp_timer_get_time() value a recent 32-bit esp_timer stamp was taken at.
+int64_t time_sync_local_us(uint32_t stamp_us);
+
+// stamp_us as Unix microseconds when synced, else as microseconds since boot.
+int64_t time_sync_us(uint32_t stamp_us);
+
+time_sync_state time_sync_get();
+
+const char *time_sync_source_name(uint8_t source);
+
+// Prints {"time":{"source","offset_us","pps_edges","pps_step_us"}}.
+void time_sync_report();
+
+#endif // TIME_SYNC_H
@@ -0,0 +1,19 @@
+#include <Arduino.h>
+#include "track.h"
+#include "uav_auth.h"
+
+UavTracker<id_data, MAX_UAVS, uav_release> tracker;
+TaskHandle_t trackNotifyTask = nullptr;
+
+void track_uas(const uint8_t *mac, int rssi, const ODID_Lean_data *lean, uint32_t captured_us, uint32_t rx_us) {
+  uint32_t now = millis();
+  tracker.lock();
+  id_data *UAV = tracker.touch(mac, now, UAV_TIMEOUT_MS);
+  UAV->rssi = rssi;
+  UAV->rx_us = rx_us;
+  uav_merge(UAV, lean, now);
+  uav_auth_pages(mac, lean, now, captured_us);
+  if (!tracker.flag(UAV)) UAV->pending_since_us = captured_us;
+  tracker.unlock();
+  if (trackNotifyTask) xTaskNotifyGive(trackNotifyTask);
+}
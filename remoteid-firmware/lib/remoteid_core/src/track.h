@@ -0,0 +1,30 @@
+/*
+ * The drone table shared by every capture path. Wi-Fi and BLE decoders hand
+ * their messages to track_uas(), which merges them into the drone's record
+ * and wakes the output task.
+ */
+
+#ifndef TRACK_H
+#define TRACK_H
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "opendroneid.h"
+#include "rid_config.h"
+#include "uav_record.h"
+#include "uav_tracker.h"
+
+extern UavTracker<id_data, MAX_UAVS, uav_release> tracker;
+
+// Task woken whenever a drone is flagged; set once by output_begin().
+extern TaskHandle_t trackNotifyTask;
+
+// Merges decoded messages into the tracked record for mac and flags it for
+// printing. A drone already waiting to be printed is not queued twice; the
+// printer will pick up this newer state instead. captured_us is the
+// esp_timer_get_time() of the capture, for the latency metrics, and rx_us
+// when the frame was received on the same clock (time_sync.h).
+void track_uas(const uint8_t *mac, int rssi, const ODID_Lean_data *lean, uint32_t captured_us, uint32_t rx_us);
+
+#endif // TRACK_H
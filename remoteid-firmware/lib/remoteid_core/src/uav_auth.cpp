@@ -0,0 +1,108 @@
+#include <string.h>
+#include "uav_auth.h"
+
+enum auth_state : uint8_t {
+  AUTH_FREE = 0,
+  AUTH_COLLECTING,
+  AUTH_READY,                         // Complete, waiting for uav_auth_take()
+  AUTH_SENT,
+};
+
+struct auth_slot {
+  uav_auth_blob blob;
+  uint16_t pages;                     // Bit n set once page n was copied
+  uint8_t  state;
+  uint32_t fed_ms;
+};
+
+static auth_slot slots[RID_AUTH_SLOTS];
+static uav_auth_stats stats;
+
+static void release(auth_slot *s, uint32_t *counter) {
+  if (s->state == AUTH_COLLECTING) (*counter)++;
+  s->state = AUTH_FREE;
+  stats.used--;
+}
+
+static void expire(uint32_t now) {
+  for (auth_slot &s : slots) {
+    if (s.state != AUTH_FREE && now - s.fed_ms > RID_AUTH_TIMEOUT_MS) release(&s, &stats.expired);
+  }
+}
+
+// mac's slot, or a new one for it: a free slot or the one fed least recently.
+static auth_slot *slot_for(const uint8_t *mac, uint32_t now) {
+  auth_slot *oldest = nullptr;
+  expire(now);
+  for (auth_slot &s : slots) {
+    if (s.state != AUTH_FREE && memcmp(s.blob.mac, mac, 6) == 0) return &s;
+  }
+  for (auth_slot &s : slots) {
+    if (s.state == AUTH_FREE) {
+      oldest = &s;
+      break;
+    }
+    if (!oldest || now - s.fed_ms > now - oldest->fed_ms) oldest = &s;
+  }
+  if (oldest->state != AUTH_FREE) release(oldest, &stats.evicted);
+  memset(oldest, 0, sizeof(*oldest));
+  memcpy(oldest->blob.mac, mac, 6);
+  oldest->state = AUTH_COLLECTING;
+  stats.used++;
+  return oldest;
+}
+
+void uav_auth_pages(const uint8_t *mac, const ODID_Lean_data *lean, uint32_t now, uint32_t captured_us) {
+  if (!(lean->Valid & ODID_LEAN_TYPE(ODID_MESSAGETYPE_AUTH)) || !lean->AuthPages) return;
+  // Relayed records (detection_frame_parse) list the pages but carry no data
+  if (!lean->AuthPageData[__builtin_ctz(lean->AuthPages)]) return;
+  auth_slot *s = slot_for(mac, now);
+  s->fed_ms = now;
+  bool page_zero = lean->AuthPages & 1;
+  if (page_zero && (s->pages & 1) && lean->AuthTimestamp != s->blob.timestamp) {
+    // A new signature; pages copied so far belong to the old one
+    s->state = AUTH_COLLECTING;
+    s->pages = 0;
+    memset(s->blob.data, 0, sizeof(s->blob.data));
+  }
+  // Only page 0 tells which signature a page belongs to
+  if (s->state != AUTH_COLLECTING) return;
+  if (page_zero) {
+    s->blob.type = lean->AuthType;
+    s->blob.last_page = lean->AuthLastPageIndex;
+    s->blob.length = lean->AuthLength;
+    s->blob.timestamp = lean->AuthTimestamp;
+  }
+  uint16_t fresh = lean->AuthPages & ~s->pages;
+  for (int n = 0; fresh; n++, fresh >>= 1) {
+    if (!(fresh & 1)) continue;
+    if (n == 0) {
+      memcpy(s->blob.data, lean->AuthPageData[0], ODID_AUTH_PAGE_ZERO_DATA_SIZE);
+    } else {
+      memcpy(s->blob.data + ODID_AUTH_PAGE_ZERO_DATA_SIZE + (n - 1) * ODID_AUTH_PAGE_NONZERO_DATA_SIZE,
+             lean->AuthPageData[n], ODID_AUTH_PAGE_NONZERO_DATA_SIZE);
+    }
+    s->pages |= (uint16_t)(1u << n);
+  }
+  uint16_t needed = (uint16_t)((2u << s->blob.last_page) - 1);
+  if ((s->pages & 1) && (s->pages & needed) == needed) {
+    s->state = AUTH_READY;
+    s->blob.captured_us = captured_us;
+    stats.completed++;
+  }
+}
+
+bool uav_auth_take(uav_auth_blob *out, uint32_t now) {
+  expire(now);
+  for (auth_slot &s : slots) {
+    if (s.state != AUTH_READY) continue;
+    *out = s.blob;
+    s.state = AUTH_SENT;
+    return true;
+  }
+  return false;
+}
+
+uav_auth_stats uav_auth_get_stats() {
+  return stats;
+}
@@ -0,0 +1,63 @@
+/*
+ * Reassembly of multi-page Authentication messages.
+ *
+ * A signature spans up to ODID_AUTH_MAX_PAGES pages, one message each, and
+ * drones cycle through them over many frames: Wi-Fi message packs and single
+ * BLE adverts alike. uav_auth_pages() copies every page it is given into the
+ * drone's slot in a fixed arena of RID_AUTH_SLOTS until page 0 and every page
+ * up to its LastPageIndex are in; uav_auth_take() then hands the blob to the
+ * printer once. The slot stays with the drone afterwards, so later rounds of
+ * the same signature (same page 0 timestamp) are not emitted again, and a new
+ * timestamp starts over.
+ *
+ * A slot not fed for RID_AUTH_TIMEOUT_MS is freed. With every slot busy the
+ * one fed least recently is given to the new drone.
+ *
+ * Nothing here touches the SDK; the caller holds the tracker lock.
+ */
+
+#ifndef UAV_AUTH_H
+#define UAV_AUTH_H
+
+#include <stdint.h>
+#include "opendroneid.h"
+
+#ifndef RID_AUTH_SLOTS
+#define RID_AUTH_SLOTS 8                // Drones whose signature is assembled at once
+#endif
+
+#ifndef RID_AUTH_TIMEOUT_MS
+#define RID_AUTH_TIMEOUT_MS 30000UL     // A slot is freed after this without a page
+#endif
+
+static_assert(RID_AUTH_SLOTS > 0 && RID_AUTH_SLOTS < 255, "auth slot count out of range");
+
+// A signature with all of its pages in.
+struct uav_auth_blob {
+  uint8_t  mac[6];
+  uint8_t  type;                      // ODID_authtype_t
+  uint8_t  last_page;
+  uint8_t  length;                    // Valid bytes in data
+  uint32_t timestamp;                 // Page 0 timestamp, seconds since 2019-01-01
+  uint32_t captured_us;               // Capture time of the page that completed it
+  uint8_t  data[MAX_AUTH_LENGTH];
+};
+
+struct uav_auth_stats {
+  uint16_t used;                      // Slots holding a drone
+  uint32_t completed;                 // Blobs assembled
+  uint32_t expired;                   // Incomplete blobs timed out
+  uint32_t evicted;                   // Incomplete blobs pushed out by another drone
+};
+
+// Adds the Auth pages decoded into lean for mac. lean's page pointers must
+// still be valid; a lean without them (a relayed record) is ignored.
+void uav_auth_pages(const uint8_t *mac, const ODID_Lean_data *lean, uint32_t now, uint32_t captured_us);
+
+// Copies out a completed blob not handed out yet and frees timed out slots.
+// False if there is none.
+bool uav_auth_take(uav_auth_blob *out, uint32_t now);
+
+uav_auth_stats uav_auth_get_stats();
+
+#endif // UAV_AUTH_H
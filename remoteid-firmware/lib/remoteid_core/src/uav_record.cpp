@@ -0,0 +1,184 @@
+#include <string.h>
+#include "uav_record.h"
+
+// Side pool for uav_cold. Slots are numbered from 1 so a zeroed record has
+// none; free slots are never handed out past coldTop and are chained through
+// coldNext once given back. Only touched under the tracker lock, like the
+// records that point into it.
+static uav_cold coldPool[RID_COLD_SLOTS];
+static uint8_t coldNext[RID_COLD_SLOTS];
+static uint8_t coldFree = UAV_COLD_NONE;
+static uint8_t coldTop = 0;
+static uint16_t coldUsed = 0;
+static uint32_t coldFull = 0;
+
+// uav's cold slot, taken from the pool on first use. nullptr if it is full.
+static uav_cold *cold_for(id_data *uav) {
+  if (uav->cold != UAV_COLD_NONE) return &coldPool[uav->cold - 1];
+  uint8_t slot;
+  if (coldFree != UAV_COLD_NONE) {
+    slot = coldFree;
+    coldFree = coldNext[slot - 1];
+  } else if (coldTop < RID_COLD_SLOTS) {
+    slot = ++coldTop;
+  } else {
+    coldFull++;
+    return nullptr;
+  }
+  uav->cold = slot;
+  coldUsed++;
+  memset(&coldPool[slot - 1], 0, sizeof(uav_cold));
+  return &coldPool[slot - 1];
+}
+
+// Assigns value to field and notes whether it changed.
+#define MERGE_FIELD(field, value) do {         \
+    if ((field) != (value)) {                  \
+      (field) = (value);                       \
+      changed = true;                          \
+    }                                          \
+  } while (0)
+
+static bool merge_string(char *dst, const char *src, size_t size) {
+  if (strncmp(dst, src, size - 1) == 0) return false;
+  strncpy(dst, src, size - 1);
+  dst[size - 1] = '\0';
+  return true;
+}
+
+static bool merge_basic_id(id_data *uav, const ODID_Lean_data *lean) {
+  bool changed = false;
+  MERGE_FIELD(uav->ua_type, lean->UAType & 0x0F);
+  MERGE_FIELD(uav->id_type, lean->IDType & 0x0F);
+  changed |= merge_string(uav->uav_id, lean->UASID, sizeof(uav->uav_id));
+  return changed;
+}
+
+static bool merge_location(id_data *uav, const ODID_Lean_data *lean) {
+  bool changed = false;
+  MERGE_FIELD(uav->status, lean->Status & 0x0F);
+  MERGE_FIELD(uav->lat_e7, lean->Latitude);
+  MERGE_FIELD(uav->long_e7, lean->Longitude);
+  MERGE_FIELD(uav->altitude_msl, lean->AltitudeGeo);
+  MERGE_FIELD(uav->height_agl, lean->Height);
+  MERGE_FIELD(uav->speed, (uint8_t)(lean->SpeedHorizontal / 100));
+  MERGE_FIELD(uav->heading, lean->Direction);
+  MERGE_FIELD(uav->speed_vertical, (int8_t)(lean->SpeedVertical / 100));
+  return changed;
+}
+
+static bool merge_auth(id_data *uav, const ODID_Lean_data *lean) {
+  uav_cold *cold = cold_for(uav);
+  if (!cold) return false;
+  bool changed = false;
+  // Page 0 first so a new signature resets the page set before it is filled
+  if (lean->AuthPages & 1) {
+    MERGE_FIELD(cold->auth_type, lean->AuthType & 0x0F);
+    MERGE_FIELD(cold->auth_last_page, lean->AuthLastPageIndex & 0x0F);
+    MERGE_FIELD(cold->auth_length, lean->AuthLength);
+    if (cold->auth_timestamp != lean->AuthTimestamp) {
+      // A new signature starts over with a fresh set of pages
+      cold->auth_timestamp = lean->AuthTimestamp;
+      cold->auth_pages = 0;
+      changed = true;
+    }
+  }
+  if (lean->AuthPages & ~cold->auth_pages) {
+    cold->auth_pages |= lean->AuthPages;
+    changed = true;
+  }
+  return changed;
+}
+
+static bool merge_self_id(id_data *uav, const ODID_Lean_data *lean) {
+  uav_cold *cold = cold_for(uav);
+  if (!cold) return false;
+  bool changed = false;
+  MERGE_FIELD(cold->desc_type, lean->DescType);
+  changed |= merge_string(cold->description, lean->Desc, sizeof(cold->description));
+  return changed;
+}
+
+static bool merge_system(id_data *uav, const ODID_Lean_data *lean) {
+  bool changed = false;
+  MERGE_FIELD(uav->base_lat_e7, lean->OperatorLatitude);
+  MERGE_FIELD(uav->base_long_e7, lean->OperatorLongitude);
+  return changed;
+}
+
+static bool merge_operator_id(id_data *uav, const ODID_Lean_data *lean) {
+  bool changed = false;
+  MERGE_FIELD(uav->operator_id_type, lean->OperatorIdType);
+  changed |= merge_string(uav->op_id, lean->OperatorId, sizeof(uav->op_id));
+  return changed;
+}
+
+typedef bool (*merge_fn)(id_data *, const ODID_Lean_data *);
+
+// Indexed by uav_group
+static const merge_fn merge_group[UAV_GROUP_COUNT] = {
+  merge_basic_id, merge_location, merge_auth, merge_self_id, merge_system, merge_operator_id,
+};
+
+uint8_t uav_merge(id_data *uav, const ODID_Lean_data *lean, uint32_t now) {
+  uint8_t received = lean->Valid & ((1u << UAV_GROUP_COUNT) - 1);
+  uint8_t changed = 0;
+
+  for (int g = 0; g < UAV_GROUP_COUNT; g++) {
+    if (!(received & UAV_GROUP_BIT(g))) continue;
+    if (merge_group[g](uav, lean)) changed |= UAV_GROUP_BIT(g);
+  }
+  // Cold groups without a slot were not stored
+  if (uav->cold == UAV_COLD_NONE) received &= ~UAV_COLD_GROUPS;
+  uint16_t tick = (uint16_t)(now >> UAV_HEARD_SHIFT);
+  for (int g = 0; g < UAV_GROUP_COUNT; g++) {
+    if (received & UAV_GROUP_BIT(g)) uav->heard[g] = tick;
+  }
+  // The first sighting of a group counts as a change even if it decoded to zeros
+  changed |= received & ~uav->valid;
+  uav->valid |= received;
+  uav->dirty |= changed;
+  if (received & UAV_GROUP_BIT(UAV_GROUP_LOCATION)) {
+    uav_track_fix(&uav->track, uav->lat_e7, uav->long_e7, now, changed & UAV_GROUP_BIT(UAV_GROUP_LOCATION));
+  }
+  return changed;
+}
+
+uint8_t uav_claim_dirty(id_data *uav, uint32_t now) {
+  if (now - uav->last_full >= UAV_FULL_REFRESH_MS) {
+    // A stale group is not refreshed, and its next reception counts as new
+    uint16_t tick = (uint16_t)(now >> UAV_HEARD_SHIFT);
+    for (int g = 0; g < UAV_GROUP_COUNT; g++) {
+      if ((uint16_t)(tick - uav->heard[g]) >= (UAV_GROUP_STALE_MS >> UAV_HEARD_SHIFT)) {
+        uav->valid &= ~UAV_GROUP_BIT(g);
+      }
+    }
+    uav->dirty |= uav->valid;
+    uav->last_full = now;
+  }
+  uint8_t dirty = uav->dirty;
+  uav->dirty = 0;
+  return dirty;
+}
+
+void uav_snapshot(const id_data *uav, uav_print *out, uint8_t groups) {
+  static_cast<uav_hot &>(*out) = *uav;
+  if ((groups & UAV_COLD_GROUPS) && uav->cold != UAV_COLD_NONE) {
+    out->cold = coldPool[uav->cold - 1];
+  } else {
+    groups &= ~UAV_COLD_GROUPS;
+  }
+  out->dirty = groups;
+}
+
+void uav_release(id_data *uav) {
+  if (uav->cold == UAV_COLD_NONE) return;
+  coldNext[uav->cold - 1] = coldFree;
+  coldFree = uav->cold;
+  coldUsed--;
+  uav->cold = UAV_COLD_NONE;
+}
+
+uav_cold_stats uav_cold_get_stats() {
+  return {coldUsed, coldFull};
+}
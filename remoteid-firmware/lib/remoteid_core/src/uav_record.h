@@ -0,0 +1,154 @@
+/*
+ * Tracked per-drone state and the incremental merge of decoded ODID messages.
+ *
+ * Each ODID message type updates only its own group of fields, so a
+ * Location-only frame no longer wipes the Basic ID or Operator ID learned from
+ * an earlier one. Groups whose content changed are flagged in `dirty` so the
+ * output side can emit just the delta. Each group also keeps when it was last
+ * received; one not heard for UAV_GROUP_STALE_MS drops out of the periodic
+ * full refresh, so the host is not handed an old Operator ID or pilot
+ * position as current, and counts as new when it comes back. Position fixes
+ * also feed the drone's track (uav_track.h), which decides when the mesh
+ * needs an update.
+ *
+ * A record is split by how often it is used. uav_hot holds what most drones
+ * send and every output needs, in fixed point and bit fields; Self ID text
+ * and Auth pages live in a small side pool (uav_cold) only for the drones
+ * that sent them. The printer copies a uav_print, which leaves out the track
+ * ring and carries the cold part only when it is being reported.
+ */
+
+#ifndef UAV_RECORD_H
+#define UAV_RECORD_H
+
+#include <stdint.h>
+#include "opendroneid.h"
+#include "uav_track.h"
+
+// Message groups merged independently. The values match ODID_messagetype_t,
+// so UAV_GROUP_BIT(g) is the ODID_LEAN_TYPE() bit of the same message type.
+enum uav_group : uint8_t {
+  UAV_GROUP_BASIC_ID    = ODID_MESSAGETYPE_BASIC_ID,
+  UAV_GROUP_LOCATION    = ODID_MESSAGETYPE_LOCATION,
+  UAV_GROUP_AUTH        = ODID_MESSAGETYPE_AUTH,
+  UAV_GROUP_SELF_ID     = ODID_MESSAGETYPE_SELF_ID,
+  UAV_GROUP_SYSTEM      = ODID_MESSAGETYPE_SYSTEM,
+  UAV_GROUP_OPERATOR_ID = ODID_MESSAGETYPE_OPERATOR_ID,
+  UAV_GROUP_COUNT
+};
+
+#define UAV_GROUP_BIT(g) ((uint8_t)(1u << (g)))
+
+// id_data::heard counts millis() in ticks of 1 << UAV_HEARD_SHIFT ms, 16 bits
+#define UAV_HEARD_SHIFT 10
+
+#ifndef UAV_FULL_REFRESH_MS
+#define UAV_FULL_REFRESH_MS 10000UL  // Re-send every known group this often
+#endif
+
+#ifndef UAV_GROUP_STALE_MS
+#define UAV_GROUP_STALE_MS 30000UL   // A group not received this long is no longer refreshed
+#endif
+
+static_assert(UAV_GROUP_STALE_MS >= UAV_FULL_REFRESH_MS, "a group would go stale between refreshes");
+static_assert((UAV_GROUP_STALE_MS >> UAV_HEARD_SHIFT) < 0x8000, "staleness must fit the 16-bit ticks");
+
+#ifndef RID_COLD_SLOTS
+#define RID_COLD_SLOTS 64            // Drones with Self ID or Auth data at once
+#endif
+
+#define UAV_COLD_NONE 0                // id_data::cold of a drone without a slot
+#define UAV_COLD_GROUPS (UAV_GROUP_BIT(UAV_GROUP_AUTH) | UAV_GROUP_BIT(UAV_GROUP_SELF_ID))
+
+static_assert(RID_COLD_SLOTS > 0 && RID_COLD_SLOTS < 255, "cold slot index is 8 bits");
+
+// Fields an output line may carry, for every drone. Enums are bit fields
+// and values are kept in the units they are printed in.
+struct uav_hot {
+  uint8_t  mac[6];
+  int8_t   rssi;
+  uint8_t  flag;                      // Set while waiting in the tracker's pending set
+  uint32_t last_seen;
+  int32_t  lat_e7;                    // Positions in 1e-7 degrees, as encoded
+  int32_t  long_e7;
+  int32_t  base_lat_e7;
+  int32_t  base_long_e7;
+  int16_t  altitude_msl;              // m
+  int16_t  height_agl;                // m
+  uint16_t heading;                   // Degrees, 361 unknown
+  uint8_t  speed;                     // m/s, 255 unknown
+  int8_t   speed_vertical;            // m/s, 63 unknown
+  uint8_t  ua_type : 4;
+  uint8_t  id_type : 4;
+  uint8_t  status : 4;
+  uint8_t  operator_id_type;
+  uint8_t  valid;                     // Groups received at least once
+  uint8_t  dirty;                     // Groups changed since the last output
+  char     uav_id[ODID_ID_SIZE + 1];
+  char     op_id[ODID_ID_SIZE + 1];
+  uint32_t pending_since_us;          // Capture time of the oldest unprinted update
+  uint32_t rx_us;                     // Reception of the newest frame, esp_timer clock
+};
+
+// Self ID and Auth, which few drones send: held in a side pool of
+// RID_COLD_SLOTS entries and only for the drones that sent them.
+struct uav_cold {
+  uint32_t auth_timestamp;
+  uint16_t auth_pages;                // Bit n set once auth page n was seen
+  uint8_t  auth_type : 4;
+  uint8_t  auth_last_page : 4;
+  uint8_t  auth_length;
+  uint8_t  desc_type;
+  char     description[ODID_STR_SIZE + 1];
+};
+
+// A tracked drone, as stored in the tracker.
+struct id_data : uav_hot {
+  uint32_t  last_full;                // millis() of the last full output
+  uint16_t  heard[UAV_GROUP_COUNT];   // Last reception of each group, UAV_HEARD_SHIFT ticks
+  uint8_t   cold;                     // Side pool slot + 1, UAV_COLD_NONE if none
+  uav_track track;                    // Smoothed position and what the mesh last got
+};
+
+// What the printer copies out of the tracker for one output: the hot
+// fields, the mesh decision and, only if reported, the cold ones.
+struct uav_print : uav_hot {
+  int32_t  mesh_lat_e7;               // Track position for the mesh update
+  int32_t  mesh_lon_e7;
+  uint8_t  mesh_due;
+  uav_cold cold;                      // Valid for the UAV_COLD_GROUPS set in dirty
+  int64_t  rx_time_us;                // rx_us on the node's synced clock (time_sync_us())
+};
+
+// Size budget of each record type, the same on every ESP32 core; output_begin()
+// prints the sizes and what the tables take at boot.
+static_assert(sizeof(uav_hot) == 92, "uav_hot layout changed");
+static_assert(sizeof(uav_cold) == 36, "uav_cold layout changed");
+static_assert(sizeof(id_data) <= sizeof(uav_hot) + 20 + sizeof(uav_track), "id_data grew");
+static_assert(sizeof(uav_print) <= sizeof(uav_hot) + 24 + sizeof(uav_cold), "uav_print grew");
+
+// Merges every message type decoded into lean. Returns the groups that changed.
+// Self ID and Auth take a cold slot on first sight; with the pool full they
+// are dropped and counted in uav_cold_stats().
+uint8_t uav_merge(id_data *uav, const ODID_Lean_data *lean, uint32_t now);
+
+// Takes the groups to output now and clears them from uav. Every group heard
+// within UAV_GROUP_STALE_MS is included once per UAV_FULL_REFRESH_MS so
+// late-joining hosts catch up; older ones are dropped from valid.
+uint8_t uav_claim_dirty(id_data *uav, uint32_t now);
+
+// Copies uav into out for an output of groups, cold fields included only
+// when groups asks for them. Sets out->dirty to the groups that can be sent.
+void uav_snapshot(const id_data *uav, uav_print *out, uint8_t groups);
+
+// Gives back uav's cold slot. The tracker calls it before dropping a record.
+void uav_release(id_data *uav);
+
+struct uav_cold_stats {
+  uint16_t used;
+  uint32_t full;                      // Self ID or Auth dropped, every slot taken
+};
+
+uav_cold_stats uav_cold_get_stats();
+
+#endif // UAV_RECORD_H
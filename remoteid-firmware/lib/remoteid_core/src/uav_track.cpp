@@ -0,0 +1,96 @@
+#include <math.h>
+#include "uav_track.h"
+
+#define METERS_PER_E7 0.0111319491f  // 1e-7 degrees of latitude
+
+static float meters_per_e7_east(int32_t lat_e7) {
+  return METERS_PER_E7 * cosf(lat_e7 * (float)(M_PI / 180e7));
+}
+
+// Least-squares line through the fixes, relative to the newest one so the
+// floats only carry small offsets.
+static void refit(uav_track *t) {
+  const uav_fix &last = t->fix[t->head];
+  float east = meters_per_e7_east(last.lat_e7);
+  float st = 0, sn = 0, se = 0, stt = 0, stn = 0, ste = 0;
+  for (uint8_t i = 0; i < t->fixes; i++) {
+    const uav_fix &f = t->fix[(t->head + RID_TRACK_FIXES - i) % RID_TRACK_FIXES];
+    float dt = -(float)(last.ms - f.ms) / 1000.0f;
+    float dn = (float)((int64_t)f.lat_e7 - last.lat_e7) * METERS_PER_E7;
+    float de = (float)((int64_t)f.lon_e7 - last.lon_e7) * east;
+    st += dt;
+    sn += dn;
+    se += de;
+    stt += dt * dt;
+    stn += dt * dn;
+    ste += dt * de;
+  }
+  float n = t->fixes;
+  float var = stt - st * st / n;
+  t->vn = t->ve = 0;
+  if (var > 0.01f) {  // Fixes at least ~0.1 s apart
+    t->vn = (stn - st * sn / n) / var;
+    t->ve = (ste - st * se / n) / var;
+  }
+  // Fitted line at the newest fix
+  float on = (sn - t->vn * st) / n;
+  float oe = (se - t->ve * st) / n;
+  t->lat_e7 = last.lat_e7 + (int32_t)lroundf(on / METERS_PER_E7);
+  t->lon_e7 = last.lon_e7 + (east > 0 ? (int32_t)lroundf(oe / east) : 0);
+  t->ms = last.ms;
+}
+
+void uav_track_fix(uav_track *t, int32_t lat_e7, int32_t lon_e7, uint32_t now, bool moved) {
+  if (lat_e7 == 0 && lon_e7 == 0) return;  // No position
+  if (t->fixes && !moved && now - t->fix[t->head].ms < RID_TRACK_FIX_INTERVAL_MS) return;
+  if (t->fixes) t->head = (uint8_t)((t->head + 1) % RID_TRACK_FIXES);
+  if (t->fixes < RID_TRACK_FIXES) t->fixes++;
+  t->fix[t->head] = {lat_e7, lon_e7, now};
+  refit(t);
+}
+
+bool uav_track_predict(const uav_track *t, uint32_t now, int32_t *lat_e7, int32_t *lon_e7) {
+  if (!t->fixes) return false;
+  uint32_t ahead = now - t->ms;
+  if ((int32_t)ahead < 0) ahead = 0;
+  if (ahead > RID_TRACK_PREDICT_MS) ahead = RID_TRACK_PREDICT_MS;
+  float s = ahead / 1000.0f;
+  float east = meters_per_e7_east(t->lat_e7);
+  *lat_e7 = t->lat_e7 + (int32_t)lroundf(t->vn * s / METERS_PER_E7);
+  *lon_e7 = t->lon_e7 + (east > 0 ? (int32_t)lroundf(t->ve * s / east) : 0);
+  return true;
+}
+
+static bool moved_far(int32_t lat_a, int32_t lon_a, int32_t lat_b, int32_t lon_b) {
+  float dn = (float)((int64_t)lat_a - lat_b) * METERS_PER_E7;
+  float de = (float)((int64_t)lon_a - lon_b) * meters_per_e7_east(lat_a);
+  return dn * dn + de * de > RID_TRACK_MESH_METERS * RID_TRACK_MESH_METERS;
+}
+
+bool uav_track_mesh_due(const uav_track *t, int32_t pilot_lat_e7, int32_t pilot_lon_e7, uint32_t now,
+                        int32_t *lat_e7, int32_t *lon_e7) {
+  int32_t lat = 0, lon = 0;
+  bool fixed = uav_track_predict(t, now, &lat, &lon);
+  *lat_e7 = lat;
+  *lon_e7 = lon;
+  bool due = !RID_TRACK_MESH_FILTER || !t->sent || now - t->sent_ms >= RID_TRACK_MESH_KEEPALIVE_MS;
+  if (!due && fixed) {
+    // The first fix after a position-less update counts as moved
+    due = (t->sent_lat_e7 == 0 && t->sent_lon_e7 == 0) ||
+          moved_far(lat, lon, t->sent_lat_e7, t->sent_lon_e7);
+  }
+  if (!due && (pilot_lat_e7 || pilot_lon_e7)) {
+    due = moved_far(pilot_lat_e7, pilot_lon_e7, t->sent_pilot_lat_e7, t->sent_pilot_lon_e7);
+  }
+  return due;
+}
+
+void uav_track_mesh_sent(uav_track *t, int32_t lat_e7, int32_t lon_e7, int32_t pilot_lat_e7,
+                         int32_t pilot_lon_e7, uint32_t now) {
+  t->sent = 1;
+  t->sent_ms = now;
+  t->sent_lat_e7 = lat_e7;
+  t->sent_lon_e7 = lon_e7;
+  t->sent_pilot_lat_e7 = pilot_lat_e7;
+  t->sent_pilot_lon_e7 = pilot_lon_e7;
+}
@@ -0,0 +1,90 @@
+/*
+ * Per-drone track for the mesh link: a small ring of recent position fixes,
+ * a least-squares fit over them for a smoothed position and velocity, and
+ * what was last sent over the mesh.
+ *
+ * The mesh only needs a new line when the map on the other end would be
+ * wrong. uav_track_mesh_due() dead-reckons the drone from the fit to now and
+ * asks for an update only once that position is RID_TRACK_MESH_METERS from
+ * the one last sent, the pilot moved as far, or RID_TRACK_MESH_KEEPALIVE_MS
+ * passed. A hovering drone then costs one line every keepalive instead of
+ * one every MESH_TX_DRONE_INTERVAL_MS, and a fast one is still followed.
+ *
+ * Nothing here touches the SDK; the caller holds the tracker lock.
+ */
+
+#ifndef UAV_TRACK_H
+#define UAV_TRACK_H
+
+#include <stdint.h>
+
+#ifndef RID_TRACK_MESH_FILTER
+#define RID_TRACK_MESH_FILTER 1               // 0 sends every update, as before
+#endif
+
+#ifndef RID_TRACK_FIXES
+#define RID_TRACK_FIXES 4                     // Fixes in the fit
+#endif
+
+#ifndef RID_TRACK_FIX_INTERVAL_MS
+#define RID_TRACK_FIX_INTERVAL_MS 500UL       // Unchanged positions are kept this often
+#endif
+
+#ifndef RID_TRACK_PREDICT_MS
+#define RID_TRACK_PREDICT_MS 5000UL           // Longest dead-reckoning past the last fix
+#endif
+
+#ifndef RID_TRACK_MESH_METERS
+#define RID_TRACK_MESH_METERS 15.0f
+#endif
+
+#ifndef RID_TRACK_MESH_KEEPALIVE_MS
+#define RID_TRACK_MESH_KEEPALIVE_MS 30000UL   // Even if nothing moved
+#endif
+
+static_assert(RID_TRACK_FIXES >= 2 && RID_TRACK_FIXES <= 16, "track ring size out of range");
+
+struct uav_fix {
+  int32_t  lat_e7;
+  int32_t  lon_e7;
+  uint32_t ms;
+};
+
+struct uav_track {
+  uav_fix  fix[RID_TRACK_FIXES];
+  uint8_t  head;                      // Slot of the newest fix
+  uint8_t  fixes;
+  uint8_t  sent;                      // A mesh update went out
+  int32_t  lat_e7;                    // Fitted position at ms
+  int32_t  lon_e7;
+  uint32_t ms;
+  float    vn;                        // Fitted velocity, m/s north and east
+  float    ve;
+  int32_t  sent_lat_e7;               // Drone and pilot positions last sent
+  int32_t  sent_lon_e7;
+  int32_t  sent_pilot_lat_e7;
+  int32_t  sent_pilot_lon_e7;
+  uint32_t sent_ms;
+};
+
+// Adds a received position and refits. moved is false when it repeats the
+// last one; repeats only count once per RID_TRACK_FIX_INTERVAL_MS, so a
+// drone that stops shows zero velocity without the ring filling up with
+// copies of one fix heard on several radios.
+void uav_track_fix(uav_track *t, int32_t lat_e7, int32_t lon_e7, uint32_t now, bool moved);
+
+// Fitted position carried forward to now, at most RID_TRACK_PREDICT_MS past
+// the last fix. False before the first fix.
+bool uav_track_predict(const uav_track *t, uint32_t now, int32_t *lat_e7, int32_t *lon_e7);
+
+// True if a mesh update should go out now, with the predicted drone position
+// to send in lat_e7 / lon_e7. Nothing is recorded until uav_track_mesh_sent().
+bool uav_track_mesh_due(const uav_track *t, int32_t pilot_lat_e7, int32_t pilot_lon_e7, uint32_t now,
+                        int32_t *lat_e7, int32_t *lon_e7);
+
+// Notes the update from uav_track_mesh_due() as sent, once the mesh queue
+// took it. An update it had no room for stays due.
+void uav_track_mesh_sent(uav_track *t, int32_t lat_e7, int32_t lon_e7, int32_t pilot_lat_e7,
+                         int32_t pilot_lon_e7, uint32_t now);
+
+#endif // UAV_TRACK_H
@@ -0,0 +1,241 @@
+/*
+ * Fixed-capacity UAV tracker keyed by the 6-byte transmitter MAC.
+ *
+ * Records live in a static array and never move. A linear-probing index
+ * (twice the capacity, so at most half full) maps a MAC to its record in O(1),
+ * and a doubly linked list through the records keeps them in last_seen order
+ * so the least recently seen drone is evicted when the table is full or its
+ * entry has aged out.
+ *
+ * Records waiting to be printed are marked in a bitmap by slot, so each drone
+ * is pending at most once: however often it updates before the printer runs,
+ * the printer copies out only its latest state.
+ *
+ * T must provide `uint8_t mac[6]`, `uint32_t last_seen` and an integer
+ * `flag`. RELEASE, if given, is called on a record before it is dropped, for
+ * records that hold something outside the table.
+ * The BLE callback and the Wi-Fi decode task both write to the tracker, so
+ * every access must sit between lock() and unlock(). Both run as tasks, and
+ * what is done under the lock (a merge with its track refit and auth page
+ * copy, a printer batch) is too long to keep interrupts off for, so the lock
+ * is a mutex rather than a spinlock. Never take it from an ISR.
+ */
+
+#ifndef UAV_TRACKER_H
+#define UAV_TRACKER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// Default RELEASE: records own nothing outside the table
+template <typename T>
+void uav_tracker_no_release(T *) {}
+
+template <typename T, uint16_t CAPACITY, void (*RELEASE)(T *) = uav_tracker_no_release<T>>
+class UavTracker {
+public:
+  static const uint16_t NONE = 0xFFFF;
+
+  UavTracker() {
+    mutex_ = xSemaphoreCreateMutexStatic(&mutexBuf_);
+    clear();
+  }
+
+  void lock() { xSemaphoreTake(mutex_, portMAX_DELAY); }
+  void unlock() { xSemaphoreGive(mutex_); }
+
+  void clear() {
+    memset(records_, 0, sizeof(records_));
+    for (uint16_t i = 0; i < INDEX_SIZE; i++) index_[i] = NONE;
+    for (uint16_t i = 0; i < CAPACITY; i++) {
+      prev_[i] = NONE;
+      next_[i] = (i + 1 < CAPACITY) ? i + 1 : NONE;
+    }
+    free_ = 0;
+    head_ = tail_ = NONE;
+    memset(pending_, 0, sizeof(pending_));
+    count_ = 0;
+    evictions_ = 0;
+    flagged_ = coalesced_ = emitted_ = 0;
+  }
+
+  // Record for mac, or nullptr if it is not tracked.
+  T *find(const uint8_t *mac) {
+    uint16_t pos = probe(mac);
+    return index_[pos] == NONE ? nullptr : &records_[index_[pos]];
+  }
+
+  // Record for mac, created if needed, and marked most recently seen at now.
+  // A new record has only mac and last_seen set. Records older than max_age_ms
+  // are expired first, then the least recently seen one is evicted if full.
+  T *touch(const uint8_t *mac, uint32_t now, uint32_t max_age_ms) {
+    uint16_t pos = probe(mac);
+    uint16_t slot = index_[pos];
+    if (slot != NONE) {
+      list_unlink(slot);
+    } else {
+      expire(now, max_age_ms);
+      if (free_ == NONE) {
+        evict(tail_);
+        evictions_++;
+      }
+      pos = probe(mac);  // Expiry may have shifted the probe chain
+      slot = free_;
+      free_ = next_[slot];
+      memset(&records_[slot], 0, sizeof(T));
+      memcpy(records_[slot].mac, mac, 6);
+      index_[pos] = slot;
+      count_++;
+    }
+    records_[slot].last_seen = now;
+    list_push_front(slot);
+    return &records_[slot];
+  }
+
+  // Drops every record not seen within max_age_ms. Returns how many.
+  uint16_t expire(uint32_t now, uint32_t max_age_ms) {
+    uint16_t dropped = 0;
+    while (tail_ != NONE && (now - records_[tail_].last_seen) > max_age_ms) {
+      evict(tail_);
+      dropped++;
+    }
+    return dropped;
+  }
+
+  // Marks rec (returned by touch()) for printing. Returns true if it was
+  // already waiting, i.e. this update was folded into the pending one.
+  bool flag(T *rec) {
+    uint16_t slot = (uint16_t)(rec - records_);
+    uint32_t bit = 1UL << (slot & 31);
+    bool waiting = pending_[slot >> 5] & bit;
+    pending_[slot >> 5] |= bit;
+    rec->flag = 1;
+    flagged_++;
+    if (waiting) coalesced_++;
+    return waiting;
+  }
+
+  // Hands up to max flagged records to copy(stored, out[i]) and clears their
+  // flag, while still locked. Lets callers print outside the lock.
+  template <typename Out, typename F>
+  uint16_t collect_flagged(Out *out, uint16_t max, F copy) {
+    uint16_t n = 0;
+    for (uint16_t w = 0; w < PENDING_WORDS && n < max; w++) {
+      while (pending_[w] && n < max) {
+        uint16_t slot = (uint16_t)(w * 32 + __builtin_ctz(pending_[w]));
+        pending_[w] &= pending_[w] - 1;
+        records_[slot].flag = 0;
+        copy(records_[slot], out[n]);
+        n++;
+      }
+    }
+    emitted_ += n;
+    return n;
+  }
+
+  uint16_t collect_flagged(T *out, uint16_t max) {
+    return collect_flagged(out, max, [](T &stored, T &copy) { copy = stored; });
+  }
+
+  uint16_t count() const { return count_; }
+  uint32_t evictions() const { return evictions_; }
+  uint32_t flagged() const { return flagged_; }      // Updates marked for printing
+  uint32_t coalesced() const { return coalesced_; }  // ...folded into one already waiting
+  uint32_t emitted() const { return emitted_; }      // Records handed to the printer
+
+private:
+  static constexpr uint16_t index_size() {
+    uint16_t n = 1;
+    while (n < 2 * CAPACITY) n <<= 1;
+    return n;
+  }
+  static const uint16_t INDEX_SIZE = index_size();
+  static const uint16_t INDEX_MASK = INDEX_SIZE - 1;
+  static const uint16_t PENDING_WORDS = (CAPACITY + 31) / 32;
+
+  static_assert(CAPACITY > 0 && CAPACITY < 0x7FFF, "tracker capacity out of range");
+
+  static uint16_t hash(const uint8_t *mac) {
+    // FNV-1a; randomized BLE/Wi-Fi addresses make every byte useful
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+      h ^= mac[i];
+      h *= 16777619u;
+    }
+    return (uint16_t)(h ^ (h >> 16)) & INDEX_MASK;
+  }
+
+  // Index position holding mac, or the empty position where it would go.
+  uint16_t probe(const uint8_t *mac) const {
+    uint16_t pos = hash(mac);
+    while (index_[pos] != NONE && memcmp(records_[index_[pos]].mac, mac, 6) != 0)
+      pos = (pos + 1) & INDEX_MASK;
+    return pos;
+  }
+
+  void evict(uint16_t slot) {
+    index_erase(probe(records_[slot].mac));
+    list_unlink(slot);
+    pending_[slot >> 5] &= ~(1UL << (slot & 31));
+    RELEASE(&records_[slot]);
+    memset(&records_[slot], 0, sizeof(T));
+    next_[slot] = free_;
+    free_ = slot;
+    count_--;
+  }
+
+  // Backward-shift deletion keeps probe chains intact without tombstones.
+  void index_erase(uint16_t hole) {
+    uint16_t j = hole;
+    for (;;) {
+      index_[hole] = NONE;
+      for (;;) {
+        j = (j + 1) & INDEX_MASK;
+        if (index_[j] == NONE) return;
+        uint16_t home = hash(records_[index_[j]].mac);
+        // Entry at j may fill the hole only if its home is not in (hole, j]
+        bool stays = (hole <= j) ? (hole < home && home <= j)
+                                 : (hole < home || home <= j);
+        if (!stays) break;
+      }
+      index_[hole] = index_[j];
+      hole = j;
+    }
+  }
+
+  void list_unlink(uint16_t slot) {
+    if (prev_[slot] != NONE) next_[prev_[slot]] = next_[slot];
+    else head_ = next_[slot];
+    if (next_[slot] != NONE) prev_[next_[slot]] = prev_[slot];
+    else tail_ = prev_[slot];
+    prev_[slot] = next_[slot] = NONE;
+  }
+
+  void list_push_front(uint16_t slot) {
+    prev_[slot] = NONE;
+    next_[slot] = head_;
+    if (head_ != NONE) prev_[head_] = slot;
+    head_ = slot;
+    if (tail_ == NONE) tail_ = slot;
+  }
+
+  T records_[CAPACITY];
+  uint16_t prev_[CAPACITY];
+  uint16_t next_[CAPACITY];   // LRU links for live records, free list otherwise
+  uint16_t index_[INDEX_SIZE];
+  uint32_t pending_[PENDING_WORDS];  // Bit per slot: flagged, not yet collected
+  uint16_t head_;             // Most recently seen
+  uint16_t tail_;             // Least recently seen
+  uint16_t free_;
+  uint16_t count_;
+  uint32_t evictions_;
+  uint32_t flagged_;
+  uint32_t coalesced_;
+  uint32_t emitted_;
+  StaticSemaphore_t mutexBuf_;  // Static so the global tracker needs no heap
+  SemaphoreHandle_t mutex_;
+};
+
+#endif // UAV_TRACKER_H
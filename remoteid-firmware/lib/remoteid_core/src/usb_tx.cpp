@@ -0,0 +1,103 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "metrics.h"
+#include "usb_tx.h"
+
+static char arena[RID_USB_TX_ARENA];
+static size_t used = 0;                  // Bytes committed
+static size_t sent = 0;                  // ...of which the driver already took
+
+// End offset and capture time of every record in the arena, in order
+static uint16_t recordEnd[RID_USB_TX_RECORDS];
+static uint32_t recordCaptured[RID_USB_TX_RECORDS];
+static uint16_t records = 0;
+static uint16_t recordsSent = 0;
+
+static uint32_t oldestMs = 0;           // millis() of the first unsent record
+static size_t driverRoom = 0;           // Most the driver ever had free: its whole ring
+static usb_tx_stats stats;
+
+void usb_tx_begin() {
+  Serial.setTxBufferSize(RID_USB_TX_DRIVER_BUFFER);
+}
+
+uint16_t usb_tx_room() {
+  if (records >= RID_USB_TX_RECORDS) return 0;
+  size_t free_bytes = sizeof(arena) - used + sent;  // Sent bytes are reclaimed on reserve
+  size_t n = free_bytes / RID_USB_TX_RECORD_MAX;
+  size_t slots = RID_USB_TX_RECORDS - records;
+  return (uint16_t)(n < slots ? n : slots);
+}
+
+// Moves the unsent tail to the start of the arena.
+static void compact() {
+  if (sent == 0) return;
+  memmove(arena, arena + sent, used - sent);
+  for (uint16_t i = recordsSent; i < records; i++) {
+    recordEnd[i - recordsSent] = (uint16_t)(recordEnd[i] - sent);
+    recordCaptured[i - recordsSent] = recordCaptured[i];
+  }
+  records -= recordsSent;
+  recordsSent = 0;
+  used -= sent;
+  sent = 0;
+}
+
+char *usb_tx_reserve() {
+  if (used + RID_USB_TX_RECORD_MAX > sizeof(arena)) compact();
+  if (used + RID_USB_TX_RECORD_MAX > sizeof(arena) || records >= RID_USB_TX_RECORDS) return nullptr;
+  return arena + used;
+}
+
+void usb_tx_commit(size_t n, uint32_t captured_us) {
+  if (n == 0 || n > RID_USB_TX_RECORD_MAX) return;
+  if (used == sent) oldestMs = millis();
+  used += n;
+  recordEnd[records] = (uint16_t)used;
+  recordCaptured[records] = captured_us;
+  records++;
+  stats.records++;
+}
+
+bool usb_tx_flush(bool force) {
+  if (sent == used) return false;
+  size_t pending = used - sent;
+  if (!force && pending < RID_USB_TX_FLUSH_BYTES && millis() - oldestMs < RID_USB_TX_FLUSH_MS) return true;
+
+  // Whole records only, up to what the driver can take now
+  size_t room = Serial.availableForWrite();
+  if (room > driverRoom) driverRoom = room;
+  uint16_t last = recordsSent;
+  while (last < records && recordEnd[last] - sent <= room) last++;
+  if (last == recordsSent) {
+    // A record longer than the driver's ring goes out alone once it drained
+    if (room < driverRoom) return true;
+    last++;
+  }
+
+  size_t n = recordEnd[last - 1] - sent;
+  Serial.write((const uint8_t *)arena + sent, n);
+  sent += n;
+  stats.bytes += n;
+  stats.writes++;
+  uint32_t now_us = (uint32_t)esp_timer_get_time();
+  for (uint16_t i = recordsSent; i < last; i++) {
+    if (recordCaptured[i] != USB_TX_NO_CAPTURE) metrics_note_latency(now_us - recordCaptured[i]);
+  }
+  recordsSent = last;
+
+  if (sent == used) {
+    used = sent = 0;
+    records = recordsSent = 0;
+    return false;
+  }
+  return true;
+}
+
+void usb_tx_note_stall() {
+  stats.stalls++;
+}
+
+usb_tx_stats usb_tx_get_stats() {
+  return stats;
+}
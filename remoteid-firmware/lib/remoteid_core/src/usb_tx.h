@@ -0,0 +1,79 @@
+/*
+ * Batched writer for detection output on USB Serial. The printer formats
+ * each record straight into a preallocated TX arena and the arena goes to
+ * the serial driver in large writes: once RID_USB_TX_FLUSH_BYTES have built
+ * up or the oldest record has waited RID_USB_TX_FLUSH_MS. Only as much as the
+ * driver's TX ring buffer can take is written, whole records only, so the
+ * printer never blocks and the heartbeat lines written by loop() never land
+ * inside a record. usb_tx_begin() sizes that ring to RID_USB_TX_DRIVER_BUFFER
+ * (the native USB CDC default is 256 bytes, shorter than a full record); a
+ * driver that keeps a smaller one gets a record longer than its room as one
+ * write once it has drained.
+ *
+ * When the host reads slower than drones update, the arena fills and
+ * usb_tx_room() stops the printer collecting. Drones then stay flagged in
+ * the tracker, so later updates coalesce into their pending state and the
+ * host gets the latest position of every drone instead of losing some.
+ *
+ * Printer task only, apart from usb_tx_get_stats().
+ */
+
+#ifndef USB_TX_H
+#define USB_TX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef RID_USB_TX_ARENA
+#define RID_USB_TX_ARENA 4096
+#endif
+
+#ifndef RID_USB_TX_FLUSH_BYTES
+#define RID_USB_TX_FLUSH_BYTES 1024
+#endif
+
+#ifndef RID_USB_TX_FLUSH_MS
+#define RID_USB_TX_FLUSH_MS 20
+#endif
+
+#ifndef RID_USB_TX_DRIVER_BUFFER
+#define RID_USB_TX_DRIVER_BUFFER RID_USB_TX_ARENA  // Serial TX ring, so a whole batch fits
+#endif
+
+#define RID_USB_TX_RECORD_MAX 600    // Longest JSON line (full detail) or binary frame
+
+static_assert(RID_USB_TX_DRIVER_BUFFER >= RID_USB_TX_FLUSH_BYTES, "a batch would never fit the driver");
+#define RID_USB_TX_RECORDS    (RID_USB_TX_ARENA / 32)
+#define USB_TX_NO_CAPTURE     0      // Record without a capture time
+
+struct usb_tx_stats {
+  uint32_t records;
+  uint32_t bytes;
+  uint32_t writes;          // Driver writes; records / writes is the batch size
+  uint32_t stalls;          // Printer passes cut short by a full arena
+};
+
+// Sizes the serial driver's TX ring. Call before Serial.begin().
+void usb_tx_begin();
+
+// Records that still fit in the arena at their largest.
+uint16_t usb_tx_room();
+
+// Free space for one record of up to RID_USB_TX_RECORD_MAX bytes, or nullptr
+// when the arena cannot take one.
+char *usb_tx_reserve();
+
+// Adds the n bytes written at the last usb_tx_reserve(). captured_us is the
+// capture time of the data in it, for the latency metrics, or
+// USB_TX_NO_CAPTURE for records that are not live detections.
+void usb_tx_commit(size_t n, uint32_t captured_us);
+
+// Writes what the driver can take, if the batch is big or old enough (or
+// force and there is anything at all). Returns true while bytes remain.
+bool usb_tx_flush(bool force);
+
+void usb_tx_note_stall();
+
+usb_tx_stats usb_tx_get_stats();
+
+#endif // USB_TX_H
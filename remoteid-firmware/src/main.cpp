@@ -0,0 +1,115 @@
+/*
+ * Wi-Fi and Bluetooth Remote ID scanner for the ESP32 family. The capture,
+ * tracking and output code lives in lib/remoteid_core; the environment in
+ * platformio.ini picks the board, the radios and node mode (see rid_config.h).
+ */
+
+#if !defined(ARDUINO_ARCH_ESP32)
+  #error "This program requires an ESP32"
+#endif
+
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <nvs_flash.h>
+#include "rid_config.h"
+#include "ble_scan.h"
+#include "boot_time.h"
+#include "capture.h"
+#include "coex.h"
+#include "espnow_link.h"
+#include "flash_log.h"
+#include "metrics.h"
+#include "output.h"
+#include "output_format.h"
+#include "task_stats.h"
+#include "time_sync.h"
+#include "usb_tx.h"
+
+unsigned long last_status = 0;
+unsigned long last_stats = 0;
+
+#if RID_NODE_MODE
+// Echoes what the mesh node sends back on Serial1 to USB Serial.
+void uartForwardTask(void *parameter) {
+  for (;;) {
+    {
+      TaskBusy busy(RID_TASK_UART);
+      while (Serial1.available()) {
+        char c = Serial1.read();
+        Serial.write(c);
+      }
+    }
+    delay(3000);  // 3-second polling interval for UART-to-USB echo
+  }
+}
+#endif
+
+// Initialize USB Serial (for JSON output) and Serial1 (for mesh/UART)
+void initializeSerial() {
+  usb_tx_begin();  // TX ring sized before the driver starts
+  Serial.begin(RID_SERIAL_BAUD);
+  Serial1.begin(RID_SERIAL1_BAUD, SERIAL_8N1, RID_SERIAL1_RX_PIN, RID_SERIAL1_TX_PIN);
+  Serial.println("USB Serial (for JSON) and UART (Serial1) initialized.");
+}
+
+#if RID_ENABLE_BLE
+// Brings BLE up next to the rest of setup(); controller and Bluedroid init
+// take longer than everything else at boot together.
+void bleInitTask(void *parameter) {
+  ble_scan_begin(coex_ble_percent());
+  coex_begin();
+  boot_time_mark(BOOT_BLE);
+  output_heap_baseline();  // Every table and stack is allocated by now
+  vTaskDelete(NULL);
+}
+#endif
+
+// Capture comes first so the radio listens while the rest starts; drones
+// found meanwhile are tracked and printed once output_begin() has run.
+void setup() {
+  setCpuFrequencyMhz(160);
+  nvs_flash_init();  // PHY calibration data, then settings
+  capture_begin();
+#if RID_ENABLE_BLE
+  xTaskCreatePinnedToCore(bleInitTask, "BLEInitTask", RID_BLE_INIT_STACK, NULL, RID_OUTPUT_PRIO, NULL,
+                          RID_OUTPUT_CORE);
+#endif
+  initializeSerial();
+  output_format_begin();
+  time_sync_begin();
+  flash_log_begin();
+  output_begin();
+  espnow_begin();
+
+#if RID_NODE_MODE
+  task_stats_create(RID_TASK_UART, uartForwardTask, "UARTForwardTask", RID_UART_STACK, RID_OUTPUT_PRIO,
+                    RID_OUTPUT_CORE, NULL);
+#endif
+  task_stats_adopt(RID_TASK_LOOP, "loopTask", CONFIG_ARDUINO_RUNNING_CORE);
+#if !RID_ENABLE_BLE
+  output_heap_baseline();
+#endif
+  boot_time_mark(BOOT_SETUP);
+}
+
+void loop() {
+  {
+    TaskBusy busy(RID_TASK_LOOP);
+    output_format_poll();
+    if (millis() >= RID_BOOT_DELAY_MS) mesh_tx_poll();
+    espnow_poll();
+    time_sync_poll();
+    coex_poll();
+  }
+  unsigned long current_millis = millis();
+  if ((current_millis - last_status) > 60000UL) {
+    output_heartbeat();
+    task_stats_report();
+    last_status = current_millis;
+  }
+  if ((current_millis - last_stats) > RID_STATS_INTERVAL_MS) {
+    metrics_report();
+    last_stats = current_millis;
+  }
+  delay(10);
+}
@@ -0,0 +1,327 @@
+/*
+ * Host replay and throughput benchmark for the capture and decode core.
+ *
+ *   pio test -e native -v
+ *   RID_BENCH_PCAP=capture.pcap pio test -e native -v
+ *
+ * The synthetic generator encodes RID_BENCH_DRONES drones with the library's
+ * own builders: NAN action frames, beacons, legacy BLE adverts (one message
+ * each) and BLE 5 extended adverts (a message pack). Every frame goes through
+ * the prefilter in rid_prefilter.h, a copy into a ring slot and the lean
+ * decoder, as on the chip; the full decoder is timed alongside for
+ * comparison. A pcap (802.11, radiotap or BLE link layer) is replayed
+ * through the same paths.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <unity.h>
+#include "opendroneid.h"
+#include "frame_ring.h"
+#include "rid_prefilter.h"
+
+#ifndef RID_BENCH_DRONES
+#define RID_BENCH_DRONES 128
+#endif
+
+#ifndef RID_BENCH_MIN_MS
+#define RID_BENCH_MIN_MS 200    // Each path is repeated for at least this long
+#endif
+
+struct bench_frame {
+  std::vector<uint8_t> bytes;
+  int32_t latitude;             // Encoded Location latitude, for the checks
+};
+
+static std::vector<bench_frame> nanFrames, beaconFrames, bleLegacy, bleExtended;
+
+static void make_drone(ODID_UAS_Data *uas, int i) {
+  odid_initUasData(uas);
+  uas->BasicID[0].UAType = ODID_UATYPE_HELICOPTER_OR_MULTIROTOR;
+  uas->BasicID[0].IDType = ODID_IDTYPE_SERIAL_NUMBER;
+  snprintf(uas->BasicID[0].UASID, sizeof(uas->BasicID[0].UASID), "BENCH%015d", i);
+  uas->BasicIDValid[0] = 1;
+  uas->Location.Status = ODID_STATUS_AIRBORNE;
+  uas->Location.Latitude = 45.0 + i * 0.001;
+  uas->Location.Longitude = -122.0 - i * 0.001;
+  uas->Location.AltitudeGeo = 100 + i;
+  uas->Location.Height = 50;
+  uas->Location.SpeedHorizontal = 10;
+  uas->Location.Direction = (float)(i % 360);
+  uas->LocationValid = 1;
+  uas->System.OperatorLatitude = 45.0;
+  uas->System.OperatorLongitude = -122.0;
+  uas->SystemValid = 1;
+  uas->OperatorID.OperatorIdType = ODID_OPERATOR_ID;
+  snprintf(uas->OperatorID.OperatorId, sizeof(uas->OperatorID.OperatorId), "OP%d", i);
+  uas->OperatorIDValid = 1;
+}
+
+static void append_ad(std::vector<uint8_t> &adv, uint8_t counter, const uint8_t *odid, size_t len) {
+  adv.push_back((uint8_t)(5 + len));
+  adv.insert(adv.end(), {0x16, 0xFA, 0xFF, 0x0D, counter});
+  adv.insert(adv.end(), odid, odid + len);
+}
+
+static void generate() {
+  if (!nanFrames.empty()) return;
+  for (int i = 0; i < RID_BENCH_DRONES; i++) {
+    ODID_UAS_Data uas;
+    make_drone(&uas, i);
+    char mac[6] = {0x60, 0x60, 0x1f, 0x00, (char)(i >> 8), (char)i};
+    int32_t lat = (int32_t)(uas.Location.Latitude * 1e7);
+    uint8_t buf[1024] = {};
+
+    // Promiscuous frames carry the FCS; the prefilter expects it
+    int len = odid_wifi_build_message_pack_nan_action_frame(&uas, mac, (uint8_t)i, buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    nanFrames.push_back({std::vector<uint8_t>(buf, buf + len + 4), lat});
+
+    len = odid_wifi_build_message_pack_beacon_frame(&uas, mac, "BENCH", 5, 100, (uint8_t)i, buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    beaconFrames.push_back({std::vector<uint8_t>(buf, buf + len + 4), lat});
+
+    // Legacy adverts are the service data alone, one message each
+    uint8_t msg[ODID_MESSAGE_SIZE];
+    encodeLocationMessage((ODID_Location_encoded *)msg, &uas.Location);
+    bench_frame legacy = {{}, lat};
+    append_ad(legacy.bytes, (uint8_t)i, msg, sizeof(msg));
+    bleLegacy.push_back(legacy);
+
+    // Extended adverts add flags and carry the whole pack
+    len = odid_message_build_pack(&uas, buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    bench_frame ext = {{0x02, 0x01, 0x06}, lat};
+    append_ad(ext.bytes, (uint8_t)i, buf, len);
+    bleExtended.push_back(ext);
+  }
+}
+
+static raw_frame slot;          // Stands in for the ring slot
+
+// Each returns 1 when frame decoded to Remote ID data, as the firmware would
+// count it, with the lean result in *lean.
+
+static int wifi_lean(const uint8_t *payload, int length, ODID_Lean_data *lean) {
+  if (length < 24 + 4) return 0;
+  if (payload[0] != FC_BEACON && payload[0] != FC_ACTION) return 0;
+  int data_len;
+  uint8_t kind;
+  const uint8_t *data = rid_wifi_candidate(payload, length, &data_len, &kind);
+  if (!data || data_len > FRAME_RING_MAX_LEN) return 0;
+  memcpy(slot.data, data, data_len);
+  odid_initLeanData(lean);
+  if (kind == FRAME_NAN_ACTION) {
+    char mac[6];
+    return odid_wifi_receive_message_pack_nan_action_frame_lean(lean, mac, slot.data, data_len, ODID_LEAN_ALL) == 0;
+  }
+  return decodeMessagePackLean(lean, slot.data, data_len, ODID_LEAN_ALL) >= 0;
+}
+
+static int wifi_full(const uint8_t *payload, int length, ODID_UAS_Data *uas) {
+  if (length < 24 + 4) return 0;
+  if (payload[0] != FC_BEACON && payload[0] != FC_ACTION) return 0;
+  int data_len;
+  uint8_t kind;
+  const uint8_t *data = rid_wifi_candidate(payload, length, &data_len, &kind);
+  if (!data || data_len > FRAME_RING_MAX_LEN) return 0;
+  memcpy(slot.data, data, data_len);
+  odid_initUasData(uas);
+  if (kind == FRAME_NAN_ACTION) {
+    char mac[6];
+    return odid_wifi_receive_message_pack_nan_action_frame(uas, mac, slot.data, data_len) == 0;
+  }
+  if (data_len < 3 || data_len < 3 + slot.data[2] * ODID_MESSAGE_SIZE) return 0;
+  return decodeMessagePack(uas, (ODID_MessagePack_encoded *)slot.data) == ODID_SUCCESS;
+}
+
+// Same length checks as the BLE GAP callback
+static const uint8_t *ble_candidate(const uint8_t *adv, int len) {
+  int odid_len;
+  const uint8_t *counter = find_odid_service_data(adv, len, &odid_len);
+  if (!counter) return nullptr;
+  const uint8_t *odid = counter + 1;
+  if (decodeMessageType(odid[0]) == ODID_MESSAGETYPE_PACKED) {
+    if (odid_len < 3 || odid_len < 3 + odid[2] * ODID_MESSAGE_SIZE) return nullptr;
+  } else if (odid_len < ODID_MESSAGE_SIZE) {
+    return nullptr;
+  }
+  return odid;
+}
+
+static int ble_lean(const uint8_t *adv, int len, ODID_Lean_data *lean) {
+  const uint8_t *odid = ble_candidate(adv, len);
+  if (!odid) return 0;
+  odid_initLeanData(lean);
+  return decodeOpenDroneIDLean(lean, odid, ODID_LEAN_ALL) != ODID_MESSAGETYPE_INVALID;
+}
+
+static int ble_full(const uint8_t *adv, int len, ODID_UAS_Data *uas) {
+  const uint8_t *odid = ble_candidate(adv, len);
+  if (!odid) return 0;
+  odid_initUasData(uas);
+  return decodeOpenDroneID(uas, (uint8_t *)odid) != ODID_MESSAGETYPE_INVALID;
+}
+
+typedef int (*lean_path)(const uint8_t *, int, ODID_Lean_data *);
+typedef int (*full_path)(const uint8_t *, int, ODID_UAS_Data *);
+
+// Runs every frame through path until RID_BENCH_MIN_MS has passed and
+// prints the rate. Returns the frames decoded in the first pass.
+template <typename Out, typename Path>
+static int bench(const char *name, const std::vector<bench_frame> &frames, Path path) {
+  using clock = std::chrono::steady_clock;
+  static Out out;
+  int decoded = 0;
+  for (const bench_frame &f : frames) decoded += path(f.bytes.data(), (int)f.bytes.size(), &out);
+  if (frames.empty()) return 0;
+
+  uint64_t n = 0;
+  volatile int sink = 0;
+  clock::time_point start = clock::now(), now;
+  do {
+    for (const bench_frame &f : frames) sink += path(f.bytes.data(), (int)f.bytes.size(), &out);
+    n += frames.size();
+    now = clock::now();
+  } while (now - start < std::chrono::milliseconds(RID_BENCH_MIN_MS));
+  double ns = std::chrono::duration<double, std::nano>(now - start).count() / n;
+  printf("%-22s %6zu frames %6d decoded %12.0f frames/s %8.1f ns/frame\n",
+         name, frames.size(), decoded, 1e9 / ns, ns);
+  (void)sink;
+  return decoded;
+}
+
+static void check_lean(const std::vector<bench_frame> &frames, lean_path path, uint8_t wanted) {
+  ODID_Lean_data lean;
+  for (const bench_frame &f : frames) {
+    TEST_ASSERT_EQUAL_INT(1, path(f.bytes.data(), (int)f.bytes.size(), &lean));
+    TEST_ASSERT_TRUE(lean.Valid & wanted);
+    TEST_ASSERT_EQUAL_INT32(f.latitude, lean.Latitude);
+  }
+}
+
+void test_synthetic_frames_decode(void) {
+  generate();
+  check_lean(nanFrames, wifi_lean, ODID_LEAN_TYPE(ODID_MESSAGETYPE_LOCATION));
+  check_lean(beaconFrames, wifi_lean, ODID_LEAN_TYPE(ODID_MESSAGETYPE_LOCATION));
+  check_lean(bleLegacy, ble_lean, ODID_LEAN_TYPE(ODID_MESSAGETYPE_LOCATION));
+  check_lean(bleExtended, ble_lean, ODID_LEAN_TYPE(ODID_MESSAGETYPE_BASIC_ID));
+}
+
+void test_synthetic_throughput(void) {
+  generate();
+  printf("\n%d synthetic drones\n", RID_BENCH_DRONES);
+  bench<ODID_Lean_data>("nan lean", nanFrames, wifi_lean);
+  bench<ODID_UAS_Data>("nan full", nanFrames, wifi_full);
+  bench<ODID_Lean_data>("beacon lean", beaconFrames, wifi_lean);
+  bench<ODID_UAS_Data>("beacon full", beaconFrames, wifi_full);
+  bench<ODID_Lean_data>("ble legacy lean", bleLegacy, ble_lean);
+  bench<ODID_UAS_Data>("ble legacy full", bleLegacy, ble_full);
+  bench<ODID_Lean_data>("ble extended lean", bleExtended, ble_lean);
+  bench<ODID_UAS_Data>("ble extended full", bleExtended, ble_full);
+}
+
+// pcap link types
+#define LINKTYPE_IEEE802_11          105
+#define LINKTYPE_IEEE802_11_RADIOTAP 127
+#define LINKTYPE_BLUETOOTH_LE_LL     251
+#define LINKTYPE_BLUETOOTH_LE_LL_PHDR 256
+
+static uint32_t rd32(const uint8_t *p, bool swap) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+// Strips the radiotap header; *has_fcs from its Flags field, if present.
+static const uint8_t *radiotap_payload(const uint8_t *p, uint32_t len, uint32_t *out_len, bool *has_fcs) {
+  if (len < 8) return nullptr;
+  uint16_t rt_len = p[2] | (p[3] << 8);
+  if (rt_len > len) return nullptr;
+  uint32_t present = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+  uint32_t off = 8;
+  for (uint32_t word = present; word & 0x80000000u && off + 4 <= rt_len; off += 4) {
+    word = p[off] | (p[off + 1] << 8) | (p[off + 2] << 16) | ((uint32_t)p[off + 3] << 24);
+  }
+  *has_fcs = false;
+  if (present & 1) off = ((off + 7) & ~7u) + 8;           // TSFT, 8 byte aligned
+  if ((present & 2) && off < rt_len) *has_fcs = p[off] & 0x10;
+  *out_len = len - rt_len;
+  return p + rt_len;
+}
+
+// Legacy advertising PDUs with AdvA followed by AdvData
+static const uint8_t *ble_ll_adv_data(const uint8_t *p, uint32_t len, uint32_t *out_len) {
+  if (len < 4 + 2 + 6) return nullptr;
+  uint8_t pdu_type = p[4] & 0x0f;
+  uint8_t pdu_len = p[5];
+  if (pdu_type != 0 && pdu_type != 2 && pdu_type != 6) return nullptr;
+  if (pdu_len < 6 || 6u + pdu_len > len) return nullptr;
+  *out_len = pdu_len - 6;
+  return p + 12;
+}
+
+void test_replay_pcap(void) {
+  const char *path = getenv("RID_BENCH_PCAP");
+  if (!path) TEST_IGNORE_MESSAGE("set RID_BENCH_PCAP to replay a capture");
+  FILE *f = fopen(path, "rb");
+  TEST_ASSERT_NOT_NULL_MESSAGE(f, path);
+  uint8_t gh[24];
+  TEST_ASSERT_EQUAL(24, fread(gh, 1, 24, f));
+  uint32_t magic;
+  memcpy(&magic, gh, 4);
+  bool swap = magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1;
+  TEST_ASSERT_TRUE_MESSAGE(swap || magic == 0xa1b2c3d4 || magic == 0xa1b23c4d, "not a pcap file");
+  uint32_t linktype = rd32(gh + 20, swap);
+
+  std::vector<bench_frame> wifi, ble;
+  std::vector<uint8_t> rec;
+  uint8_t rh[16];
+  while (fread(rh, 1, 16, f) == 16) {
+    uint32_t caplen = rd32(rh + 8, swap);
+    if (caplen > 65535) break;
+    rec.resize(caplen);
+    if (fread(rec.data(), 1, caplen, f) != caplen) break;
+    const uint8_t *p = rec.data();
+    uint32_t len = caplen;
+    bool has_fcs = false;
+    if (linktype == LINKTYPE_IEEE802_11_RADIOTAP) {
+      p = radiotap_payload(p, len, &len, &has_fcs);
+    } else if (linktype == LINKTYPE_BLUETOOTH_LE_LL_PHDR) {
+      p = len > 10 ? ble_ll_adv_data(p + 10, len - 10, &len) : nullptr;
+    } else if (linktype == LINKTYPE_BLUETOOTH_LE_LL) {
+      p = ble_ll_adv_data(p, len, &len);
+    } else if (linktype != LINKTYPE_IEEE802_11) {
+      TEST_FAIL_MESSAGE("unsupported link type");
+    }
+    if (!p) continue;
+    bench_frame frame = {std::vector<uint8_t>(p, p + len), 0};
+    if (linktype == LINKTYPE_BLUETOOTH_LE_LL || linktype == LINKTYPE_BLUETOOTH_LE_LL_PHDR) {
+      ble.push_back(frame);
+    } else {
+      if (!has_fcs) frame.bytes.resize(len + 4);  // The driver always hands over the FCS
+      wifi.push_back(frame);
+    }
+  }
+  fclose(f);
+
+  printf("\nreplay of %s\n", path);
+  bench<ODID_Lean_data>("wifi lean", wifi, wifi_lean);
+  bench<ODID_UAS_Data>("wifi full", wifi, wifi_full);
+  bench<ODID_Lean_data>("ble lean", ble, ble_lean);
+  bench<ODID_UAS_Data>("ble full", ble, ble_full);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_synthetic_frames_decode);
+  RUN_TEST(test_synthetic_throughput);
+  RUN_TEST(test_replay_pcap);
+  return UNITY_END();
+}
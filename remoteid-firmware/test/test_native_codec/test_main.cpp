@@ -0,0 +1,288 @@
+/*
+ * Checks the table and integer field codecs in opendroneid.c against the
+ * float code they replaced, over every encoded input.
+ *
+ *   pio test -e native -v -f test_native_codec
+ *
+ * The ref_ functions below are the former bodies. Decoded values are
+ * compared bit for bit. Every Direction, speed, vertical speed, altitude
+ * and accuracy byte is decoded; the accuracy enum builders are run over
+ * every float bit pattern, NaN and infinities included, in strides of
+ * RID_CODEC_FLOAT_STRIDE (1 covers all 2^32), plus every float within
+ * RID_CODEC_NEAR_ULPS of each bound.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include "opendroneid.h"
+
+#ifndef RID_CODEC_FLOAT_STRIDE
+#define RID_CODEC_FLOAT_STRIDE 251   // 1 for every float, about 3 minutes
+#endif
+
+#ifndef RID_CODEC_NEAR_ULPS
+#define RID_CODEC_NEAR_ULPS 4096
+#endif
+
+static const float SPEED_DIV_REF[2] = {0.25f, 0.75f};
+
+static float ref_decodeDirection(uint8_t Direction_enc, uint8_t EWDirection) {
+  if (EWDirection)
+    return (float)Direction_enc + 180;
+  else
+    return (float)Direction_enc;
+}
+
+static float ref_decodeSpeedHorizontal(uint8_t Speed_enc, uint8_t mult) {
+  if (mult)
+    return ((float)Speed_enc * SPEED_DIV_REF[1]) + (UINT8_MAX * SPEED_DIV_REF[0]);
+  else
+    return (float)Speed_enc * SPEED_DIV_REF[0];
+}
+
+static float ref_decodeSpeedVertical(int8_t SpeedVertical_enc) {
+  return (float)SpeedVertical_enc * 0.5f;
+}
+
+static float ref_decodeAltitude(uint16_t Alt_enc) {
+  return (float)Alt_enc * 0.5f - (float)1000;
+}
+
+static float ref_decodeTimeStamp(uint16_t Seconds_enc) {
+  if (Seconds_enc == INV_TIMESTAMP)
+    return INV_TIMESTAMP;
+  else
+    return (float)Seconds_enc / 10;
+}
+
+static int ref_createEnumHorizontalAccuracy(float Accuracy) {
+  if (Accuracy >= 18520) return ODID_HOR_ACC_UNKNOWN;
+  else if (Accuracy >= 7408) return ODID_HOR_ACC_10NM;
+  else if (Accuracy >= 3704) return ODID_HOR_ACC_4NM;
+  else if (Accuracy >= 1852) return ODID_HOR_ACC_2NM;
+  else if (Accuracy >= 926) return ODID_HOR_ACC_1NM;
+  else if (Accuracy >= 555.6f) return ODID_HOR_ACC_0_5NM;
+  else if (Accuracy >= 185.2f) return ODID_HOR_ACC_0_3NM;
+  else if (Accuracy >= 92.6f) return ODID_HOR_ACC_0_1NM;
+  else if (Accuracy >= 30) return ODID_HOR_ACC_0_05NM;
+  else if (Accuracy >= 10) return ODID_HOR_ACC_30_METER;
+  else if (Accuracy >= 3) return ODID_HOR_ACC_10_METER;
+  else if (Accuracy >= 1) return ODID_HOR_ACC_3_METER;
+  else if (Accuracy > 0) return ODID_HOR_ACC_1_METER;
+  else return ODID_HOR_ACC_UNKNOWN;
+}
+
+static int ref_createEnumVerticalAccuracy(float Accuracy) {
+  if (Accuracy >= 150) return ODID_VER_ACC_UNKNOWN;
+  else if (Accuracy >= 45) return ODID_VER_ACC_150_METER;
+  else if (Accuracy >= 25) return ODID_VER_ACC_45_METER;
+  else if (Accuracy >= 10) return ODID_VER_ACC_25_METER;
+  else if (Accuracy >= 3) return ODID_VER_ACC_10_METER;
+  else if (Accuracy >= 1) return ODID_VER_ACC_3_METER;
+  else if (Accuracy > 0) return ODID_VER_ACC_1_METER;
+  else return ODID_VER_ACC_UNKNOWN;
+}
+
+static int ref_createEnumSpeedAccuracy(float Accuracy) {
+  if (Accuracy >= 10) return ODID_SPEED_ACC_UNKNOWN;
+  else if (Accuracy >= 3) return ODID_SPEED_ACC_10_METERS_PER_SECOND;
+  else if (Accuracy >= 1) return ODID_SPEED_ACC_3_METERS_PER_SECOND;
+  else if (Accuracy >= 0.3f) return ODID_SPEED_ACC_1_METERS_PER_SECOND;
+  else if (Accuracy > 0) return ODID_SPEED_ACC_0_3_METERS_PER_SECOND;
+  else return ODID_SPEED_ACC_UNKNOWN;
+}
+
+static int ref_createEnumTimestampAccuracy(float Accuracy) {
+  if (Accuracy > 1.5f) return ODID_TIME_ACC_UNKNOWN;
+  else if (Accuracy > 1.4f) return ODID_TIME_ACC_1_5_SECOND;
+  else if (Accuracy > 1.3f) return ODID_TIME_ACC_1_4_SECOND;
+  else if (Accuracy > 1.2f) return ODID_TIME_ACC_1_3_SECOND;
+  else if (Accuracy > 1.1f) return ODID_TIME_ACC_1_2_SECOND;
+  else if (Accuracy > 1.0f) return ODID_TIME_ACC_1_1_SECOND;
+  else if (Accuracy > 0.9f) return ODID_TIME_ACC_1_0_SECOND;
+  else if (Accuracy > 0.8f) return ODID_TIME_ACC_0_9_SECOND;
+  else if (Accuracy > 0.7f) return ODID_TIME_ACC_0_8_SECOND;
+  else if (Accuracy > 0.6f) return ODID_TIME_ACC_0_7_SECOND;
+  else if (Accuracy > 0.5f) return ODID_TIME_ACC_0_6_SECOND;
+  else if (Accuracy > 0.4f) return ODID_TIME_ACC_0_5_SECOND;
+  else if (Accuracy > 0.3f) return ODID_TIME_ACC_0_4_SECOND;
+  else if (Accuracy > 0.2f) return ODID_TIME_ACC_0_3_SECOND;
+  else if (Accuracy > 0.1f) return ODID_TIME_ACC_0_2_SECOND;
+  else if (Accuracy > 0.0f) return ODID_TIME_ACC_0_1_SECOND;
+  else return ODID_TIME_ACC_UNKNOWN;
+}
+
+static float ref_decodeHorizontalAccuracy(int Accuracy) {
+  switch (Accuracy) {
+  case ODID_HOR_ACC_UNKNOWN: return 18520;
+  case ODID_HOR_ACC_10NM: return 18520;
+  case ODID_HOR_ACC_4NM: return 7808;
+  case ODID_HOR_ACC_2NM: return 3704;
+  case ODID_HOR_ACC_1NM: return 1852;
+  case ODID_HOR_ACC_0_5NM: return 926;
+  case ODID_HOR_ACC_0_3NM: return 555.6f;
+  case ODID_HOR_ACC_0_1NM: return 185.2f;
+  case ODID_HOR_ACC_0_05NM: return 92.6f;
+  case ODID_HOR_ACC_30_METER: return 30;
+  case ODID_HOR_ACC_10_METER: return 10;
+  case ODID_HOR_ACC_3_METER: return 3;
+  case ODID_HOR_ACC_1_METER: return 1;
+  default: return 18520;
+  }
+}
+
+static float ref_decodeVerticalAccuracy(int Accuracy) {
+  switch (Accuracy) {
+  case ODID_VER_ACC_UNKNOWN: return 150;
+  case ODID_VER_ACC_150_METER: return 150;
+  case ODID_VER_ACC_45_METER: return 45;
+  case ODID_VER_ACC_25_METER: return 25;
+  case ODID_VER_ACC_10_METER: return 10;
+  case ODID_VER_ACC_3_METER: return 3;
+  case ODID_VER_ACC_1_METER: return 1;
+  default: return 150;
+  }
+}
+
+static float ref_decodeSpeedAccuracy(int Accuracy) {
+  switch (Accuracy) {
+  case ODID_SPEED_ACC_UNKNOWN: return 10;
+  case ODID_SPEED_ACC_10_METERS_PER_SECOND: return 10;
+  case ODID_SPEED_ACC_3_METERS_PER_SECOND: return 3;
+  case ODID_SPEED_ACC_1_METERS_PER_SECOND: return 1;
+  case ODID_SPEED_ACC_0_3_METERS_PER_SECOND: return 0.3f;
+  default: return 10;
+  }
+}
+
+static float ref_decodeTimestampAccuracy(int Accuracy) {
+  switch (Accuracy) {
+  case ODID_TIME_ACC_UNKNOWN: return 0.0f;
+  case ODID_TIME_ACC_0_1_SECOND: return 0.1f;
+  case ODID_TIME_ACC_0_2_SECOND: return 0.2f;
+  case ODID_TIME_ACC_0_3_SECOND: return 0.3f;
+  case ODID_TIME_ACC_0_4_SECOND: return 0.4f;
+  case ODID_TIME_ACC_0_5_SECOND: return 0.5f;
+  case ODID_TIME_ACC_0_6_SECOND: return 0.6f;
+  case ODID_TIME_ACC_0_7_SECOND: return 0.7f;
+  case ODID_TIME_ACC_0_8_SECOND: return 0.8f;
+  case ODID_TIME_ACC_0_9_SECOND: return 0.9f;
+  case ODID_TIME_ACC_1_0_SECOND: return 1.0f;
+  case ODID_TIME_ACC_1_1_SECOND: return 1.1f;
+  case ODID_TIME_ACC_1_2_SECOND: return 1.2f;
+  case ODID_TIME_ACC_1_3_SECOND: return 1.3f;
+  case ODID_TIME_ACC_1_4_SECOND: return 1.4f;
+  case ODID_TIME_ACC_1_5_SECOND: return 1.5f;
+  default: return 0.0f;
+  }
+}
+
+static uint32_t float_bits(float f) {
+  uint32_t u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static float bits_float(uint32_t u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+#define TEST_ASSERT_SAME_FLOAT(expected, actual) TEST_ASSERT_EQUAL_HEX32(float_bits(expected), float_bits(actual))
+
+static void decode_location(ODID_Location_encoded *enc, ODID_Location_data *out) {
+  enc->MessageType = ODID_MESSAGETYPE_LOCATION;
+  TEST_ASSERT_EQUAL(ODID_SUCCESS, decodeLocationMessage(out, enc));
+}
+
+void test_location_fields(void) {
+  ODID_Location_encoded enc;
+  ODID_Location_data out;
+  for (int flags = 0; flags < 4; flags++) {
+    for (int v = 0; v <= UINT8_MAX; v++) {
+      memset(&enc, 0, sizeof(enc));
+      enc.EWDirection = flags & 1;
+      enc.SpeedMult = flags >> 1;
+      enc.Direction = (uint8_t)v;
+      enc.SpeedHorizontal = (uint8_t)v;
+      enc.SpeedVertical = (int8_t)v;
+      decode_location(&enc, &out);
+      TEST_ASSERT_SAME_FLOAT(ref_decodeDirection(enc.Direction, enc.EWDirection), out.Direction);
+      TEST_ASSERT_SAME_FLOAT(ref_decodeSpeedHorizontal(enc.SpeedHorizontal, enc.SpeedMult), out.SpeedHorizontal);
+      TEST_ASSERT_SAME_FLOAT(ref_decodeSpeedVertical(enc.SpeedVertical), out.SpeedVertical);
+    }
+  }
+  for (uint32_t v = 0; v <= UINT16_MAX; v++) {
+    memset(&enc, 0, sizeof(enc));
+    enc.AltitudeBaro = enc.AltitudeGeo = enc.Height = enc.TimeStamp = (uint16_t)v;
+    enc.HorizAccuracy = enc.VertAccuracy = enc.BaroAccuracy = enc.SpeedAccuracy = enc.TSAccuracy = v & 0xF;
+    decode_location(&enc, &out);
+    TEST_ASSERT_SAME_FLOAT(ref_decodeAltitude(enc.AltitudeBaro), out.AltitudeBaro);
+    TEST_ASSERT_SAME_FLOAT(ref_decodeAltitude(enc.AltitudeGeo), out.AltitudeGeo);
+    TEST_ASSERT_SAME_FLOAT(ref_decodeAltitude(enc.Height), out.Height);
+    TEST_ASSERT_SAME_FLOAT(ref_decodeTimeStamp(enc.TimeStamp), out.TimeStamp);
+  }
+}
+
+void test_system_altitudes(void) {
+  ODID_System_encoded enc;
+  ODID_System_data out;
+  for (uint32_t v = 0; v <= UINT16_MAX; v++) {
+    memset(&enc, 0, sizeof(enc));
+    enc.MessageType = ODID_MESSAGETYPE_SYSTEM;
+    enc.AreaCeiling = enc.AreaFloor = enc.OperatorAltitudeGeo = (uint16_t)v;
+    TEST_ASSERT_EQUAL(ODID_SUCCESS, decodeSystemMessage(&out, &enc));
+    TEST_ASSERT_SAME_FLOAT(ref_decodeAltitude(enc.AreaCeiling), out.AreaCeiling);
+    TEST_ASSERT_SAME_FLOAT(ref_decodeAltitude(enc.AreaFloor), out.AreaFloor);
+    TEST_ASSERT_SAME_FLOAT(ref_decodeAltitude(enc.OperatorAltitudeGeo), out.OperatorAltitudeGeo);
+  }
+}
+
+void test_accuracy_decode(void) {
+  // Beyond the 4 encoded bits too, as the functions take any enum value
+  for (int a = 0; a <= UINT8_MAX; a++) {
+    TEST_ASSERT_SAME_FLOAT(ref_decodeHorizontalAccuracy(a), decodeHorizontalAccuracy((ODID_Horizontal_accuracy_t)a));
+    TEST_ASSERT_SAME_FLOAT(ref_decodeVerticalAccuracy(a), decodeVerticalAccuracy((ODID_Vertical_accuracy_t)a));
+    TEST_ASSERT_SAME_FLOAT(ref_decodeSpeedAccuracy(a), decodeSpeedAccuracy((ODID_Speed_accuracy_t)a));
+    TEST_ASSERT_SAME_FLOAT(ref_decodeTimestampAccuracy(a), decodeTimestampAccuracy((ODID_Timestamp_accuracy_t)a));
+  }
+}
+
+static void check_create(float f) {
+  TEST_ASSERT_EQUAL_INT(ref_createEnumHorizontalAccuracy(f), createEnumHorizontalAccuracy(f));
+  TEST_ASSERT_EQUAL_INT(ref_createEnumVerticalAccuracy(f), createEnumVerticalAccuracy(f));
+  TEST_ASSERT_EQUAL_INT(ref_createEnumSpeedAccuracy(f), createEnumSpeedAccuracy(f));
+  TEST_ASSERT_EQUAL_INT(ref_createEnumTimestampAccuracy(f), createEnumTimestampAccuracy(f));
+}
+
+void test_accuracy_create(void) {
+  // Around every bound, where a changed comparison would show
+  static const float bounds[] = {
+    18520, 7408, 3704, 1852, 926, 555.6f, 185.2f, 92.6f, 30, 10, 3, 1, 0.3f,
+    150, 45, 25, 1.5f, 1.4f, 1.3f, 1.2f, 1.1f, 1.0f, 0.9f, 0.8f, 0.7f, 0.6f,
+    0.5f, 0.4f, 0.2f, 0.1f, 0.0f, -0.0f, INFINITY, -INFINITY,
+  };
+  for (float b : bounds) {
+    uint32_t u = float_bits(b);
+    for (int32_t d = -RID_CODEC_NEAR_ULPS; d <= RID_CODEC_NEAR_ULPS; d++) check_create(bits_float(u + d));
+  }
+  uint64_t checked = 0;
+  for (uint64_t u = 0; u <= UINT32_MAX; u += RID_CODEC_FLOAT_STRIDE, checked++) check_create(bits_float((uint32_t)u));
+  check_create(bits_float(UINT32_MAX));
+  printf("\n%llu float inputs per enum builder\n", (unsigned long long)checked);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_location_fields);
+  RUN_TEST(test_system_altitudes);
+  RUN_TEST(test_accuracy_decode);
+  RUN_TEST(test_accuracy_create);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+/*
+ * Checks and times the detection line writer in json_writer.h against the
+ * snprintf formatting it replaced.
+ *
+ *   pio test -e native -v -f test_native_json
+ *
+ * The snprintf version below is the former send_json_fast() body, with the
+ * coordinates scaled to doubles and printed with "%.6f". Both run over the
+ * same RID_BENCH_DRONES records with every group set; cycles are counted
+ * with the time stamp counter on x86 hosts and left out elsewhere.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <unity.h>
+#include "json_writer.h"
+#include "usb_tx.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc()
+#endif
+
+#ifndef RID_BENCH_DRONES
+#define RID_BENCH_DRONES 128
+#endif
+
+#ifndef RID_BENCH_MIN_MS
+#define RID_BENCH_MIN_MS 200    // Each formatter is repeated for at least this long
+#endif
+
+#define LINE_MAX_LEN (RID_USB_TX_RECORD_MAX - 1)  // As send_json_fast() gets it
+
+static const uint8_t ALL_GROUPS = (1u << UAV_GROUP_COUNT) - 1;
+
+static std::vector<uav_print> drones;
+
+static void generate() {
+  if (!drones.empty()) return;
+  srand(1);
+  for (int i = 0; i < RID_BENCH_DRONES; i++) {
+    uav_print uav = {};
+    uint8_t mac[6] = {0x60, 0x60, 0x1f, (uint8_t)rand(), (uint8_t)(i >> 8), (uint8_t)i};
+    memcpy(uav.mac, mac, 6);
+    uav.rssi = -30 - rand() % 70;
+    // Synced Unix microseconds, microseconds since boot, or not received yet
+    if (i % 3 == 0) uav.rx_time_us = 1760000000000000LL + (int64_t)i * 1234567;
+    else if (i % 3 == 1) uav.rx_time_us = (int64_t)i * 7919;
+    // Both hemispheres, down to a few 1e-7 degrees from zero
+    uav.lat_e7 = (int32_t)((rand() % 1800000001) - 900000000) >> (i % 8 == 0 ? 24 : 0);
+    uav.long_e7 = (int32_t)((rand() % 2000000001) - 1000000000) * (i % 2 ? 1 : -1);
+    uav.base_lat_e7 = uav.lat_e7 + rand() % 10000;
+    uav.base_long_e7 = uav.long_e7 - rand() % 10000;
+    uav.altitude_msl = rand() % 1200 - 100;
+    uav.height_agl = rand() % 400;
+    uav.speed = rand() % 40;
+    uav.speed_vertical = rand() % 20 - 10;
+    uav.heading = rand() % 360;
+    uav.status = ODID_STATUS_AIRBORNE;
+    uav.ua_type = ODID_UATYPE_HELICOPTER_OR_MULTIROTOR;
+    uav.id_type = ODID_IDTYPE_SERIAL_NUMBER;
+    snprintf(uav.uav_id, sizeof(uav.uav_id), "BENCH%015d", i);
+    snprintf(uav.op_id, sizeof(uav.op_id), "OP\"%d\\", i);  // Needs escaping
+    snprintf(uav.cold.description, sizeof(uav.cold.description), "Survey flight %d", i);
+    uav.cold.auth_type = 1;
+    uav.cold.auth_last_page = 4;
+    uav.cold.auth_pages = 0x1f;
+    uav.cold.auth_length = 100;
+    uav.cold.auth_timestamp = 12345678u * i;
+    uav.dirty = ALL_GROUPS;
+    drones.push_back(uav);
+  }
+}
+
+static void json_safe_copy(char *dst, const char *src, size_t size) {
+  size_t i = 0;
+  for (; i + 1 < size && src[i]; i++) {
+    char c = src[i];
+    dst[i] = (c < 0x20 || c > 0x7e || c == '"' || c == '\\') ? '_' : c;
+  }
+  dst[i] = '\0';
+}
+
+// The formatting send_json_fast() did before json_writer.h, plus rx_us
+static size_t snprintf_json(char *json_msg, size_t size, const uav_print *UAV, uint8_t groups, bool) {
+  char text[ODID_STR_SIZE + 1];
+  size_t n = 0;
+#define JSON_APPEND(...) do { \
+    if (n < size) n += snprintf(json_msg + n, size - n, __VA_ARGS__); \
+  } while (0)
+  JSON_APPEND("{\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\"rssi\":%d",
+              UAV->mac[0], UAV->mac[1], UAV->mac[2],
+              UAV->mac[3], UAV->mac[4], UAV->mac[5], UAV->rssi);
+  if (UAV->rx_time_us > 0) JSON_APPEND(",\"rx_us\":%lld", (long long)UAV->rx_time_us);
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_LOCATION)) {
+    JSON_APPEND(",\"drone_lat\":%.6f,\"drone_long\":%.6f,\"drone_altitude\":%d",
+                UAV->lat_e7 / 1e7, UAV->long_e7 / 1e7, UAV->altitude_msl);
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_SYSTEM)) {
+    JSON_APPEND(",\"pilot_lat\":%.6f,\"pilot_long\":%.6f",
+                UAV->base_lat_e7 / 1e7, UAV->base_long_e7 / 1e7);
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_BASIC_ID)) {
+    json_safe_copy(text, UAV->uav_id, sizeof(text));
+    JSON_APPEND(",\"basic_id\":\"%s\",\"ua_type\":%d", text, UAV->ua_type);
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_OPERATOR_ID)) {
+    json_safe_copy(text, UAV->op_id, sizeof(text));
+    JSON_APPEND(",\"operator_id\":\"%s\"", text);
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_SELF_ID)) {
+    json_safe_copy(text, UAV->cold.description, sizeof(text));
+    JSON_APPEND(",\"description\":\"%s\"", text);
+  }
+  if (groups & UAV_GROUP_BIT(UAV_GROUP_AUTH)) {
+    JSON_APPEND(",\"auth_type\":%d,\"auth_last_page\":%d,\"auth_pages\":%u",
+                UAV->cold.auth_type, UAV->cold.auth_last_page, (unsigned)UAV->cold.auth_pages);
+  }
+  JSON_APPEND("}");
+#undef JSON_APPEND
+  return n < size ? n : 0;
+}
+
+// A tie in the seventh decimal may go either way in the double version
+static bool coordinate_tie(const uav_print &uav) {
+  return uav.lat_e7 % 10 == 5 || uav.lat_e7 % 10 == -5 || uav.long_e7 % 10 == 5 || uav.long_e7 % 10 == -5 ||
+         uav.base_lat_e7 % 10 == 5 || uav.base_lat_e7 % 10 == -5 ||
+         uav.base_long_e7 % 10 == 5 || uav.base_long_e7 % 10 == -5;
+}
+
+void test_compact_matches_snprintf(void) {
+  generate();
+  char fast[LINE_MAX_LEN + 1], ref[LINE_MAX_LEN + 1];
+  for (const uav_print &uav : drones) {
+    for (uint8_t groups = 0; groups <= ALL_GROUPS; groups++) {
+      size_t n = uav_json(fast, LINE_MAX_LEN, &uav, groups, false);
+      size_t m = snprintf_json(ref, LINE_MAX_LEN, &uav, groups, false);
+      TEST_ASSERT_GREATER_THAN(0, n);
+      fast[n] = '\0';
+      if (coordinate_tie(uav)) continue;
+      // "%.6f" writes -0.000000 for tiny negative values; the writer drops the sign
+      if (strstr(ref, ":-0.000000")) continue;
+      TEST_ASSERT_EQUAL_size_t(m, n);
+      TEST_ASSERT_EQUAL_STRING(ref, fast);
+    }
+  }
+}
+
+void test_degrees(void) {
+  static const struct { int32_t e7; const char *text; } cases[] = {
+    {0, "0.000000"}, {4, "0.000000"}, {5, "0.000001"}, {-4, "0.000000"}, {-5, "-0.000001"},
+    {15, "0.000002"}, {9999995, "1.000000"}, {-1234567890, "-123.456789"},
+    {1800000000, "180.000000"}, {-1800000000, "-180.000000"},
+    {INT32_MAX, "214.748365"}, {INT32_MIN, "-214.748365"},
+  };
+  for (const auto &c : cases) {
+    char buf[16];
+    JsonWriter w(buf, sizeof(buf) - 1);
+    w.degrees(c.e7);
+    buf[w.length()] = '\0';
+    TEST_ASSERT_EQUAL_STRING(c.text, buf);
+  }
+}
+
+void test_u64(void) {
+  static const struct { uint64_t v; const char *text; } cases[] = {
+    {0, "0"}, {UINT32_MAX, "4294967295"}, {(uint64_t)UINT32_MAX + 1, "4294967296"},
+    {1760000000123456ULL, "1760000000123456"}, {UINT64_MAX, "18446744073709551615"},
+  };
+  for (const auto &c : cases) {
+    char buf[24];
+    JsonWriter w(buf, sizeof(buf) - 1);
+    w.u64(c.v);
+    buf[w.length()] = '\0';
+    TEST_ASSERT_EQUAL_STRING(c.text, buf);
+  }
+}
+
+void test_full_and_overflow(void) {
+  generate();
+  char buf[LINE_MAX_LEN + 1];
+  const uav_print &uav = drones[1];
+  size_t compact = uav_json(buf, LINE_MAX_LEN, &uav, ALL_GROUPS, false);
+  size_t full = uav_json(buf, LINE_MAX_LEN, &uav, ALL_GROUPS, true);
+  buf[full] = '\0';
+  TEST_ASSERT_GREATER_THAN(compact, full);
+  TEST_ASSERT_NOT_NULL(strstr(buf, ",\"heading\":"));
+  TEST_ASSERT_NOT_NULL(strstr(buf, ",\"operator_id\":\"OP_1_\""));
+  TEST_ASSERT_EQUAL('}', buf[full - 1]);
+  // A line that does not fit is refused rather than cut short
+  TEST_ASSERT_EQUAL_size_t(0, uav_json(buf, full - 1, &uav, ALL_GROUPS, true));
+  TEST_ASSERT_EQUAL_size_t(full, uav_json(buf, full, &uav, ALL_GROUPS, true));
+}
+
+typedef size_t (*formatter)(char *, size_t, const uav_print *, uint8_t, bool);
+
+// Formats every record until RID_BENCH_MIN_MS has passed and prints the
+// cost per record.
+static void bench(const char *name, formatter format, bool full) {
+  using clock = std::chrono::steady_clock;
+  static char buf[LINE_MAX_LEN];
+  uint64_t n = 0;
+  size_t bytes = 0;
+  volatile size_t sink = 0;
+#ifdef BENCH_CYCLES
+  uint64_t c0 = BENCH_CYCLES();
+#endif
+  clock::time_point start = clock::now(), now;
+  do {
+    for (const uav_print &uav : drones) sink += format(buf, sizeof(buf), &uav, ALL_GROUPS, full);
+    n += drones.size();
+    now = clock::now();
+  } while (now - start < std::chrono::milliseconds(RID_BENCH_MIN_MS));
+  for (const uav_print &uav : drones) bytes += format(buf, sizeof(buf), &uav, ALL_GROUPS, full);
+  double ns = std::chrono::duration<double, std::nano>(now - start).count() / n;
+#ifdef BENCH_CYCLES
+  printf("%-16s %6.1f bytes/record %8.1f ns/record %8.0f cycles/record\n",
+         name, (double)bytes / drones.size(), ns, (double)(BENCH_CYCLES() - c0) / n);
+#else
+  printf("%-16s %6.1f bytes/record %8.1f ns/record\n", name, (double)bytes / drones.size(), ns);
+#endif
+  (void)sink;
+}
+
+void test_serializer_throughput(void) {
+  generate();
+  printf("\n%d records, every group\n", RID_BENCH_DRONES);
+  bench("snprintf", snprintf_json, false);
+  bench("writer compact", uav_json, false);
+  bench("writer full", uav_json, true);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int argc, char **argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_degrees);
+  RUN_TEST(test_u64);
+  RUN_TEST(test_compact_matches_snprintf);
+  RUN_TEST(test_full_and_overflow);
+  RUN_TEST(test_serializer_throughput);
+  return UNITY_END();
+}